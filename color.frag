@@ -21,6 +21,10 @@ void main() {
 
     color = vec4(light_intensity.rrr * tint, 1.0);
 
+#ifdef WRITE_FRAG_DEPTH
+    // Only used by --benchmark-fragments to time the old path. The depth is the one the rasterizer
+    // writes anyway, but writing it here turns off early depth testing.
     vec4 clip_position = common_uniforms.view_projection_matrix * vec4(vertex_output.world_position, 1.0);
-    gl_FragDepth = 1.0 - clip_position.z / clip_position.w;
+    gl_FragDepth = clip_position.z / clip_position.w;
+#endif
 }
\ No newline at end of file
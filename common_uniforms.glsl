@@ -1,6 +1,7 @@
 layout (set = COMMON_UNIFORM_BINDING_SET, binding = 0) uniform CommonUniformBlock {
     float time;
     float instance_count;
+    float far_plane;
 
     mat4 view_matrix;
     mat4 projection_matrix;
@@ -0,0 +1,623 @@
+#include <string.h>
+
+#include "gpu_resources.h"
+
+//  Pool sizes, in vertices and indices. Meshes too big for one get a pool of their own.
+#define GPU_VERTEX_POOL_CAPACITY (1u << 20)
+#define GPU_INDEX_POOL_CAPACITY  (4u << 20)
+#define GPU_MAX_POOLS 32
+
+//  How many frames the GPU can still be reading a mesh after it was last used
+#define GPU_FRAMES_IN_FLIGHT 3
+
+typedef struct GpuRange {
+    Uint32 first;
+    Uint32 count;
+} GpuRange;
+
+typedef struct GpuPool {
+    SDL_GPUBuffer *buffer;
+    Uint32 capacity;
+    Uint32 used;
+    Uint32 num_allocations;
+
+    //  Sorted and coalesced. Always has room for one more, so freeing never has to allocate.
+    GpuRange *free_ranges;
+    Uint32 num_free_ranges;
+    Uint32 free_ranges_capacity;
+} GpuPool;
+
+typedef struct GpuPoolSet {
+    GpuMemoryCategory category;
+    SDL_GPUBufferUsageFlags usage;
+    Uint32 element_size;
+    Uint32 default_capacity;
+    const char *name;
+
+    GpuPool pools[GPU_MAX_POOLS];
+} GpuPoolSet;
+
+typedef struct GpuMeshSlot {
+    Uint32 generation;
+    bool allocated;
+    bool streamable;
+
+    Uint32 vertex_pool;
+    Uint32 first_vertex;
+    Uint32 num_vertices;
+
+    Uint32 index_pool;
+    Uint32 first_index;
+    Uint32 num_indices;
+
+    Uint64 last_used_frame;
+} GpuMeshSlot;
+
+typedef struct GpuTextureRecord {
+    SDL_GPUTexture *texture;
+    GpuMemoryCategory category;
+    Uint64 size;
+} GpuTextureRecord;
+
+struct GpuResources {
+    SDL_GPUDevice *gpu;
+    Uint64 budget;
+    Uint64 frame;
+
+    GpuPoolSet vertex_pools;
+    GpuPoolSet index_pools;
+
+    GpuMeshSlot *meshes;
+    Uint32 num_mesh_slots;
+    Uint32 mesh_slots_capacity;
+
+    GpuTextureRecord *textures;
+    Uint32 num_textures;
+    Uint32 textures_capacity;
+
+    Uint64 reserved[GPU_MEMORY_CATEGORY_COUNT];
+    Uint64 used[GPU_MEMORY_CATEGORY_COUNT];
+
+    Uint32 num_buffers;
+    Uint32 num_meshes;
+    Uint32 num_evictions;
+};
+
+//  Only running out of room is worth evicting meshes for. Running out of CPU memory, or the device
+//  failing, fails the allocation straight away.
+typedef enum GpuAllocation {
+    GPU_ALLOCATION_SUCCEEDED,
+    GPU_ALLOCATION_NO_ROOM,
+    GPU_ALLOCATION_FAILED,
+} GpuAllocation;
+
+static bool Reserve(void **data, Uint32 *capacity, Uint32 needed, size_t element_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+
+    Uint32 new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_data = SDL_realloc(*data, new_capacity * element_size);
+    if (!new_data) {
+        return false;
+    }
+
+    *data = new_data;
+    *capacity = new_capacity;
+    return true;
+}
+
+static Uint64 TotalReserved(const GpuResources *resources) {
+    Uint64 total = 0;
+    for (int category = 0; category < GPU_MEMORY_CATEGORY_COUNT; ++category) {
+        total += resources->reserved[category];
+    }
+
+    return total;
+}
+
+static GpuAllocation CreatePool(GpuResources *resources, GpuPoolSet *set, GpuPool *pool, Uint32 capacity) {
+    Uint64 size = (Uint64) capacity * set->element_size;
+    if (TotalReserved(resources) + size > resources->budget) {
+        return GPU_ALLOCATION_NO_ROOM;
+    }
+
+    //  Room for the single free range, plus the one freeing the first allocation can add
+    pool->free_ranges = SDL_malloc(2 * sizeof(GpuRange));
+    if (!pool->free_ranges) {
+        SDL_SetError("Out of memory creating a %s.", set->name);
+        return GPU_ALLOCATION_FAILED;
+    }
+
+    SDL_GPUBufferCreateInfo buffer_descriptor = {
+        .usage = set->usage,
+        .size = (Uint32) size,
+    };
+
+    pool->buffer = SDL_CreateGPUBuffer(resources->gpu, &buffer_descriptor);
+    if (!pool->buffer) {
+        SDL_free(pool->free_ranges);
+        pool->free_ranges = NULL;
+        return GPU_ALLOCATION_FAILED;
+    }
+
+    SDL_SetGPUBufferName(resources->gpu, pool->buffer, set->name);
+
+    pool->capacity = capacity;
+    pool->used = 0;
+    pool->num_allocations = 0;
+    pool->free_ranges[0] = (GpuRange) { .first = 0, .count = capacity };
+    pool->num_free_ranges = 1;
+    pool->free_ranges_capacity = 2;
+
+    resources->reserved[set->category] += size;
+    resources->num_buffers += 1;
+    return GPU_ALLOCATION_SUCCEEDED;
+}
+
+static void ReleasePool(GpuResources *resources, GpuPoolSet *set, GpuPool *pool) {
+    SDL_ReleaseGPUBuffer(resources->gpu, pool->buffer);
+    SDL_free(pool->free_ranges);
+
+    resources->reserved[set->category] -= (Uint64) pool->capacity * set->element_size;
+    resources->num_buffers -= 1;
+
+    SDL_zerop(pool);
+}
+
+//  First fit
+static GpuAllocation AllocateFromPool(GpuPool *pool, Uint32 count, Uint32 *first) {
+    for (Uint32 i = 0; i < pool->num_free_ranges; ++i) {
+        GpuRange *range = &pool->free_ranges[i];
+        if (range->count < count) {
+            continue;
+        }
+
+        //  Each allocation can split at most one free range in two when it's freed
+        if (!Reserve((void **) &pool->free_ranges, &pool->free_ranges_capacity, pool->num_allocations + 2, sizeof(GpuRange))) {
+            SDL_SetError("Out of memory growing a pool's free list.");
+            return GPU_ALLOCATION_FAILED;
+        }
+
+        range = &pool->free_ranges[i];
+        *first = range->first;
+        range->first += count;
+        range->count -= count;
+
+        if (range->count == 0) {
+            memmove(range, range + 1, (pool->num_free_ranges - i - 1) * sizeof(GpuRange));
+            pool->num_free_ranges -= 1;
+        }
+
+        pool->used += count;
+        pool->num_allocations += 1;
+        return GPU_ALLOCATION_SUCCEEDED;
+    }
+
+    return GPU_ALLOCATION_NO_ROOM;
+}
+
+static void FreeToPool(GpuPool *pool, Uint32 first, Uint32 count) {
+    Uint32 insert = 0;
+    while (insert < pool->num_free_ranges && pool->free_ranges[insert].first < first) {
+        ++insert;
+    }
+
+    bool merges_previous = insert > 0 && pool->free_ranges[insert - 1].first + pool->free_ranges[insert - 1].count == first;
+    bool merges_next = insert < pool->num_free_ranges && first + count == pool->free_ranges[insert].first;
+
+    if (merges_previous && merges_next) {
+        pool->free_ranges[insert - 1].count += count + pool->free_ranges[insert].count;
+        memmove(&pool->free_ranges[insert], &pool->free_ranges[insert + 1], (pool->num_free_ranges - insert - 1) * sizeof(GpuRange));
+        pool->num_free_ranges -= 1;
+    } else if (merges_previous) {
+        pool->free_ranges[insert - 1].count += count;
+    } else if (merges_next) {
+        pool->free_ranges[insert].first = first;
+        pool->free_ranges[insert].count += count;
+    } else {
+        memmove(&pool->free_ranges[insert + 1], &pool->free_ranges[insert], (pool->num_free_ranges - insert) * sizeof(GpuRange));
+        pool->free_ranges[insert] = (GpuRange) { .first = first, .count = count };
+        pool->num_free_ranges += 1;
+    }
+
+    pool->used -= count;
+    pool->num_allocations -= 1;
+}
+
+//  Tries the existing pools, then a new one if it fits in the budget
+static GpuAllocation AllocateFromPoolSet(GpuResources *resources, GpuPoolSet *set, Uint32 count, Uint32 *pool_index, Uint32 *first) {
+    for (Uint32 i = 0; i < GPU_MAX_POOLS; ++i) {
+        GpuPool *pool = &set->pools[i];
+        if (!pool->buffer) {
+            continue;
+        }
+
+        GpuAllocation allocation = AllocateFromPool(pool, count, first);
+        if (allocation == GPU_ALLOCATION_SUCCEEDED) {
+            *pool_index = i;
+            resources->used[set->category] += (Uint64) count * set->element_size;
+        }
+
+        if (allocation != GPU_ALLOCATION_NO_ROOM) {
+            return allocation;
+        }
+    }
+
+    for (Uint32 i = 0; i < GPU_MAX_POOLS; ++i) {
+        GpuPool *pool = &set->pools[i];
+        if (pool->buffer) {
+            continue;
+        }
+
+        GpuAllocation allocation = CreatePool(resources, set, pool, SDL_max(count, set->default_capacity));
+        if (allocation != GPU_ALLOCATION_SUCCEEDED) {
+            return allocation;
+        }
+
+        //  Can't fail, the new pool's single free range fits and its free list already has room
+        AllocateFromPool(pool, count, first);
+        *pool_index = i;
+        resources->used[set->category] += (Uint64) count * set->element_size;
+        return GPU_ALLOCATION_SUCCEEDED;
+    }
+
+    return GPU_ALLOCATION_NO_ROOM;
+}
+
+static void FreeToPoolSet(GpuResources *resources, GpuPoolSet *set, Uint32 pool_index, Uint32 first, Uint32 count) {
+    FreeToPool(&set->pools[pool_index], first, count);
+    resources->used[set->category] -= (Uint64) count * set->element_size;
+}
+
+static bool ReleaseEmptyPools(GpuResources *resources) {
+    bool released = false;
+
+    GpuPoolSet *sets[] = { &resources->vertex_pools, &resources->index_pools };
+    for (Uint32 set = 0; set < SDL_arraysize(sets); ++set) {
+        for (Uint32 i = 0; i < GPU_MAX_POOLS; ++i) {
+            GpuPool *pool = &sets[set]->pools[i];
+            if (pool->buffer && pool->num_allocations == 0) {
+                ReleasePool(resources, sets[set], pool);
+                released = true;
+            }
+        }
+    }
+
+    return released;
+}
+
+static void FreeMeshSlot(GpuResources *resources, GpuMeshSlot *slot) {
+    FreeToPoolSet(resources, &resources->vertex_pools, slot->vertex_pool, slot->first_vertex, slot->num_vertices);
+    FreeToPoolSet(resources, &resources->index_pools, slot->index_pool, slot->first_index, slot->num_indices);
+
+    slot->allocated = false;
+    slot->generation += 1;
+    resources->num_meshes -= 1;
+}
+
+//  Evicts the least recently used streamable mesh the GPU is done with, and gives back any pools
+//  that leaves empty
+static bool EvictLeastRecentlyUsed(GpuResources *resources) {
+    GpuMeshSlot *victim = NULL;
+    for (Uint32 i = 0; i < resources->num_mesh_slots; ++i) {
+        GpuMeshSlot *slot = &resources->meshes[i];
+        if (!slot->allocated || !slot->streamable || slot->last_used_frame + GPU_FRAMES_IN_FLIGHT > resources->frame) {
+            continue;
+        }
+
+        if (!victim || slot->last_used_frame < victim->last_used_frame) {
+            victim = slot;
+        }
+    }
+
+    if (!victim) {
+        return false;
+    }
+
+    FreeMeshSlot(resources, victim);
+    resources->num_evictions += 1;
+
+    ReleaseEmptyPools(resources);
+    return true;
+}
+
+//  Frees memory while there's no room for the allocation, until it fits or there's nothing left to free
+static GpuAllocation AllocateWithEviction(GpuResources *resources, GpuPoolSet *set, Uint32 count, Uint32 *pool_index, Uint32 *first) {
+    for (;;) {
+        GpuAllocation allocation = AllocateFromPoolSet(resources, set, count, pool_index, first);
+        if (allocation != GPU_ALLOCATION_NO_ROOM) {
+            return allocation;
+        }
+
+        if (!ReleaseEmptyPools(resources) && !EvictLeastRecentlyUsed(resources)) {
+            return GPU_ALLOCATION_NO_ROOM;
+        }
+    }
+}
+
+GpuResources *CreateGpuResources(SDL_GPUDevice *gpu, Uint32 vertex_size, Uint64 budget) {
+    GpuResources *resources = SDL_calloc(1, sizeof(GpuResources));
+    if (!resources) {
+        return NULL;
+    }
+
+    resources->gpu = gpu;
+    resources->budget = budget;
+
+    resources->vertex_pools = (GpuPoolSet) {
+        .category = GPU_MEMORY_MESH_VERTICES,
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+        .element_size = vertex_size,
+        .default_capacity = GPU_VERTEX_POOL_CAPACITY,
+        .name = "Mesh Vertex Pool",
+    };
+
+    resources->index_pools = (GpuPoolSet) {
+        .category = GPU_MEMORY_MESH_INDICES,
+        .usage = SDL_GPU_BUFFERUSAGE_INDEX,
+        .element_size = sizeof(Uint32),
+        .default_capacity = GPU_INDEX_POOL_CAPACITY,
+        .name = "Mesh Index Pool",
+    };
+
+    return resources;
+}
+
+void DestroyGpuResources(GpuResources *resources) {
+    if (!resources) {
+        return;
+    }
+
+    GpuPoolSet *sets[] = { &resources->vertex_pools, &resources->index_pools };
+    for (Uint32 set = 0; set < SDL_arraysize(sets); ++set) {
+        for (Uint32 i = 0; i < GPU_MAX_POOLS; ++i) {
+            if (sets[set]->pools[i].buffer) {
+                ReleasePool(resources, sets[set], &sets[set]->pools[i]);
+            }
+        }
+    }
+
+    for (Uint32 i = 0; i < resources->num_textures; ++i) {
+        SDL_ReleaseGPUTexture(resources->gpu, resources->textures[i].texture);
+    }
+
+    SDL_free(resources->meshes);
+    SDL_free(resources->textures);
+    SDL_free(resources);
+}
+
+void BeginGpuResourcesFrame(GpuResources *resources) {
+    resources->frame += 1;
+}
+
+bool UploadGpuMesh(GpuResources *resources, const void *vertices, Uint32 num_vertices, const Uint32 *indices, Uint32 num_indices, bool streamable, GpuMeshHandle *handle) {
+    if (num_vertices == 0 || num_indices == 0) {
+        return SDL_SetError("Mesh has no geometry.");
+    }
+
+    Uint32 slot_index = 0;
+    while (slot_index < resources->num_mesh_slots && resources->meshes[slot_index].allocated) {
+        ++slot_index;
+    }
+
+    if (slot_index == resources->num_mesh_slots) {
+        if (!Reserve((void **) &resources->meshes, &resources->mesh_slots_capacity, resources->num_mesh_slots + 1, sizeof(GpuMeshSlot))) {
+            return SDL_SetError("Out of memory growing mesh slots.");
+        }
+
+        resources->meshes[resources->num_mesh_slots++] = (GpuMeshSlot) { .generation = 1 };
+    }
+
+    GpuMeshSlot slot = resources->meshes[slot_index];
+    slot.streamable = streamable;
+    slot.num_vertices = num_vertices;
+    slot.num_indices = num_indices;
+
+    GpuAllocation vertex_allocation = AllocateWithEviction(resources, &resources->vertex_pools, num_vertices, &slot.vertex_pool, &slot.first_vertex);
+    if (vertex_allocation != GPU_ALLOCATION_SUCCEEDED) {
+        return vertex_allocation == GPU_ALLOCATION_NO_ROOM ? SDL_SetError("Out of GPU memory budget for %u vertices.", num_vertices) : false;
+    }
+
+    GpuAllocation index_allocation = AllocateWithEviction(resources, &resources->index_pools, num_indices, &slot.index_pool, &slot.first_index);
+    if (index_allocation != GPU_ALLOCATION_SUCCEEDED) {
+        FreeToPoolSet(resources, &resources->vertex_pools, slot.vertex_pool, slot.first_vertex, num_vertices);
+        return index_allocation == GPU_ALLOCATION_NO_ROOM ? SDL_SetError("Out of GPU memory budget for %u indices.", num_indices) : false;
+    }
+
+    Uint32 vertices_size = num_vertices * resources->vertex_pools.element_size;
+    Uint32 indices_size = num_indices * sizeof(Uint32);
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_descriptor = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = vertices_size + indices_size,
+    };
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(resources->gpu, &transfer_buffer_descriptor);
+    Uint8 *mapped = transfer_buffer ? SDL_MapGPUTransferBuffer(resources->gpu, transfer_buffer, false) : NULL;
+    SDL_GPUCommandBuffer *command_buffer = mapped ? SDL_AcquireGPUCommandBuffer(resources->gpu) : NULL;
+
+    bool uploaded = false;
+    if (command_buffer) {
+        memcpy(mapped, vertices, vertices_size);
+        memcpy(mapped + vertices_size, indices, indices_size);
+        SDL_UnmapGPUTransferBuffer(resources->gpu, transfer_buffer);
+
+        SDL_GPUCopyPass *pass = SDL_BeginGPUCopyPass(command_buffer);
+
+        SDL_UploadToGPUBuffer(pass,
+            &(SDL_GPUTransferBufferLocation) { .transfer_buffer = transfer_buffer },
+            &(SDL_GPUBufferRegion) {
+                .buffer = resources->vertex_pools.pools[slot.vertex_pool].buffer,
+                .offset = slot.first_vertex * resources->vertex_pools.element_size,
+                .size = vertices_size,
+            }, false);
+
+        SDL_UploadToGPUBuffer(pass,
+            &(SDL_GPUTransferBufferLocation) { .transfer_buffer = transfer_buffer, .offset = vertices_size },
+            &(SDL_GPUBufferRegion) {
+                .buffer = resources->index_pools.pools[slot.index_pool].buffer,
+                .offset = slot.first_index * sizeof(Uint32),
+                .size = indices_size,
+            }, false);
+
+        SDL_EndGPUCopyPass(pass);
+
+        uploaded = SDL_SubmitGPUCommandBuffer(command_buffer);
+    } else if (mapped) {
+        SDL_UnmapGPUTransferBuffer(resources->gpu, transfer_buffer);
+    }
+
+    if (transfer_buffer) {
+        SDL_ReleaseGPUTransferBuffer(resources->gpu, transfer_buffer);
+    }
+
+    if (!uploaded) {
+        FreeToPoolSet(resources, &resources->vertex_pools, slot.vertex_pool, slot.first_vertex, num_vertices);
+        FreeToPoolSet(resources, &resources->index_pools, slot.index_pool, slot.first_index, num_indices);
+        return false;
+    }
+
+    //  Counts as used, so it isn't evicted before it's drawn for the first time
+    slot.allocated = true;
+    slot.last_used_frame = resources->frame;
+    resources->meshes[slot_index] = slot;
+    resources->num_meshes += 1;
+
+    *handle = (GpuMeshHandle) { .index = slot_index, .generation = slot.generation };
+    return true;
+}
+
+static GpuMeshSlot *GetMeshSlot(GpuResources *resources, GpuMeshHandle handle) {
+    if (handle.index >= resources->num_mesh_slots) {
+        return NULL;
+    }
+
+    GpuMeshSlot *slot = &resources->meshes[handle.index];
+    if (!slot->allocated || slot->generation != handle.generation) {
+        return NULL;
+    }
+
+    return slot;
+}
+
+void ReleaseGpuMesh(GpuResources *resources, GpuMeshHandle handle) {
+    GpuMeshSlot *slot = GetMeshSlot(resources, handle);
+    if (slot) {
+        FreeMeshSlot(resources, slot);
+    }
+}
+
+bool UseGpuMesh(GpuResources *resources, GpuMeshHandle handle, GpuMeshLocation *location) {
+    GpuMeshSlot *slot = GetMeshSlot(resources, handle);
+    if (!slot) {
+        return false;
+    }
+
+    slot->last_used_frame = resources->frame;
+
+    *location = (GpuMeshLocation) {
+        .vertex_buffer = resources->vertex_pools.pools[slot->vertex_pool].buffer,
+        .index_buffer  = resources->index_pools.pools[slot->index_pool].buffer,
+        .first_vertex  = slot->first_vertex,
+        .first_index   = slot->first_index,
+        .num_indices   = slot->num_indices,
+    };
+
+    return true;
+}
+
+SDL_GPUTexture *CreateGpuTexture(GpuResources *resources, GpuMemoryCategory category, const SDL_GPUTextureCreateInfo *descriptor, const char *name) {
+    Uint64 size = 0;
+    for (Uint32 level = 0; level < descriptor->num_levels; ++level) {
+        Uint32 width = SDL_max(descriptor->width >> level, 1);
+        Uint32 height = SDL_max(descriptor->height >> level, 1);
+        Uint32 depth = descriptor->type == SDL_GPU_TEXTURETYPE_3D ? SDL_max(descriptor->layer_count_or_depth >> level, 1) : descriptor->layer_count_or_depth;
+        size += SDL_CalculateGPUTextureFormatSize(descriptor->format, width, height, depth);
+    }
+
+    //  Before evicting anything, so running out of CPU memory doesn't cost any meshes
+    if (!Reserve((void **) &resources->textures, &resources->textures_capacity, resources->num_textures + 1, sizeof(GpuTextureRecord))) {
+        SDL_SetError("Out of memory tracking textures.");
+        return NULL;
+    }
+
+    while (TotalReserved(resources) + size > resources->budget) {
+        if (!ReleaseEmptyPools(resources) && !EvictLeastRecentlyUsed(resources)) {
+            SDL_SetError("Out of GPU memory budget for \"%s\", %.1f MB.", name, size / (1024.0 * 1024.0));
+            return NULL;
+        }
+    }
+
+    SDL_GPUTexture *texture = SDL_CreateGPUTexture(resources->gpu, descriptor);
+    if (!texture) {
+        return NULL;
+    }
+
+    SDL_SetGPUTextureName(resources->gpu, texture, name);
+
+    resources->textures[resources->num_textures++] = (GpuTextureRecord) {
+        .texture = texture,
+        .category = category,
+        .size = size,
+    };
+
+    resources->reserved[category] += size;
+    resources->used[category] += size;
+    return texture;
+}
+
+void ReleaseGpuTexture(GpuResources *resources, SDL_GPUTexture *texture) {
+    for (Uint32 i = 0; i < resources->num_textures; ++i) {
+        GpuTextureRecord *record = &resources->textures[i];
+        if (record->texture != texture) {
+            continue;
+        }
+
+        resources->reserved[record->category] -= record->size;
+        resources->used[record->category] -= record->size;
+        SDL_ReleaseGPUTexture(resources->gpu, texture);
+
+        *record = resources->textures[--resources->num_textures];
+        return;
+    }
+}
+
+void GetGpuMemoryStats(const GpuResources *resources, GpuMemoryStats *stats) {
+    SDL_zerop(stats);
+    stats->budget = resources->budget;
+
+    for (int category = 0; category < GPU_MEMORY_CATEGORY_COUNT; ++category) {
+        stats->reserved[category] = resources->reserved[category];
+        stats->used[category] = resources->used[category];
+    }
+
+    stats->num_buffers = resources->num_buffers;
+    stats->num_textures = resources->num_textures;
+    stats->num_meshes = resources->num_meshes;
+    stats->num_evictions = resources->num_evictions;
+}
+
+void LogGpuMemoryStats(const GpuResources *resources) {
+    const char *category_names[GPU_MEMORY_CATEGORY_COUNT] = {
+        "Mesh vertices",
+        "Mesh indices",
+        "Render targets",
+    };
+
+    GpuMemoryStats stats;
+    GetGpuMemoryStats(resources, &stats);
+
+    const double mb = 1024.0 * 1024.0;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GPU memory: %.1f of %.1f MB budget, %u buffers, %u textures, %u meshes, %u evictions",
+        TotalReserved(resources) / mb, stats.budget / mb, stats.num_buffers, stats.num_textures, stats.num_meshes, stats.num_evictions);
+
+    for (int category = 0; category < GPU_MEMORY_CATEGORY_COUNT; ++category) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-14s %8.1f MB used, %8.1f MB reserved", category_names[category], stats.used[category] / mb, stats.reserved[category] / mb);
+    }
+}
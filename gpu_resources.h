@@ -0,0 +1,78 @@
+#ifndef GPU_RESOURCES_H
+#define GPU_RESOURCES_H
+
+#include "SDL3/SDL.h"
+
+//  Owns the engine's GPU buffers and textures, and accounts for every byte of them against a budget.
+//
+//  Mesh vertices and indices are sub-allocated out of large pooled buffers, so any number of meshes
+//  share a handful of buffer objects and draws only rebind when they cross a pool. Meshes are
+//  referred to by handle. A streamable mesh can be evicted, least recently used first, to make room
+//  for a new allocation once the budget is reached, after which its handle stops resolving and the
+//  owner has to upload it again.
+//
+//  Not thread safe, every call is expected on the thread that renders.
+
+typedef enum GpuMemoryCategory {
+    GPU_MEMORY_MESH_VERTICES,
+    GPU_MEMORY_MESH_INDICES,
+    GPU_MEMORY_RENDER_TARGETS,
+    GPU_MEMORY_CATEGORY_COUNT,
+} GpuMemoryCategory;
+
+typedef struct GpuResources GpuResources;
+
+//  generation 0 is never handed out, so a zeroed handle is always invalid
+typedef struct GpuMeshHandle {
+    Uint32 index;
+    Uint32 generation;
+} GpuMeshHandle;
+
+//  Where a mesh lives in its pools. Indices are relative to first_vertex, which is passed to the
+//  draw as the vertex offset.
+typedef struct GpuMeshLocation {
+    SDL_GPUBuffer *vertex_buffer;
+    SDL_GPUBuffer *index_buffer;
+    Uint32 first_vertex;
+    Uint32 first_index;
+    Uint32 num_indices;
+} GpuMeshLocation;
+
+typedef struct GpuMemoryStats {
+    Uint64 budget;
+
+    //  Bytes of GPU memory created, and how much of it is handed out. For the mesh pools reserved
+    //  includes free space, for textures the two are the same.
+    Uint64 reserved[GPU_MEMORY_CATEGORY_COUNT];
+    Uint64 used[GPU_MEMORY_CATEGORY_COUNT];
+
+    Uint32 num_buffers;
+    Uint32 num_textures;
+    Uint32 num_meshes;
+    Uint32 num_evictions;
+} GpuMemoryStats;
+
+//  All meshes share one vertex layout, vertex_size bytes per vertex
+GpuResources *CreateGpuResources(SDL_GPUDevice *gpu, Uint32 vertex_size, Uint64 budget);
+void DestroyGpuResources(GpuResources *resources);
+
+//  Starts a new frame for LRU purposes. Meshes used in the last few frames may still be read by
+//  the GPU, and are never evicted.
+void BeginGpuResourcesFrame(GpuResources *resources);
+
+//  Allocates pool space, evicting streamable meshes if it's needed to stay in budget, and uploads
+//  the mesh. On failure returns false, and the reason is available from SDL_GetError.
+bool UploadGpuMesh(GpuResources *resources, const void *vertices, Uint32 num_vertices, const Uint32 *indices, Uint32 num_indices, bool streamable, GpuMeshHandle *handle);
+void ReleaseGpuMesh(GpuResources *resources, GpuMeshHandle handle);
+
+//  Marks the mesh as used this frame. Returns false once it has been evicted or released.
+bool UseGpuMesh(GpuResources *resources, GpuMeshHandle handle, GpuMeshLocation *location);
+
+//  Textures are never evicted, they fail instead if the budget can't be met
+SDL_GPUTexture *CreateGpuTexture(GpuResources *resources, GpuMemoryCategory category, const SDL_GPUTextureCreateInfo *descriptor, const char *name);
+void ReleaseGpuTexture(GpuResources *resources, SDL_GPUTexture *texture);
+
+void GetGpuMemoryStats(const GpuResources *resources, GpuMemoryStats *stats);
+void LogGpuMemoryStats(const GpuResources *resources);
+
+#endif
@@ -0,0 +1,29 @@
+// Grid - based on the work of Ben Golus. (https://bgolus.medium.com/the-best-darn-grid-shader-yet-727f9278b9d8#1e7c)
+// tweaked from there for multiple grid scales, and major grid lines
+float grid(vec2 uv, float line_width, float grid_scale) {
+    uv *= grid_scale > 0.0 ? 1.0 / grid_scale : 0.0;
+    line_width = clamp(0.01, 0.0, 1.0);
+
+    bool invert_line = (line_width > 0.5);
+    float target_width = invert_line ? 1.0 - line_width : line_width;
+
+    vec4 uv_ddxy = vec4(dFdx(uv), dFdy(uv));
+    vec2 uv_derivative = vec2(length(uv_ddxy.xz), length(uv_ddxy.yw));
+
+    vec2 draw_width = clamp(target_width.xx, uv_derivative, 0.5.xx);
+
+    vec2 line_aa = uv_derivative * 1.5;
+    vec2 grid_uv = abs(fract(uv) * 2.0 - 1.0);
+    grid_uv = vec2(
+        invert_line ? grid_uv.r : 1.0 - grid_uv.r,
+        invert_line ? grid_uv.g : 1.0 - grid_uv.g);
+
+    vec2 grid_mask = smoothstep(draw_width + line_aa, draw_width - line_aa, grid_uv);
+    grid_mask *= clamp(target_width / draw_width, 0.0.rr, 1.0.rr);
+    grid_mask = mix(grid_mask, target_width.xx, clamp(uv_derivative * 2.0 - 1.0, 0.0.rr, 1.0.rr));
+    grid_mask = vec2(
+        invert_line ? 1.0 - grid_mask.r : grid_mask.r,
+        invert_line ? 1.0 - grid_mask.g : grid_mask.g);
+
+    return mix(grid_mask.x, 1.0, grid_mask.y);
+}
@@ -3,35 +3,34 @@
 
 //output
 layout (location = 1) out VertexOutput {
-    vec3 near;
-    vec3 far;
-
-    mat4 view_projection_matrix;
+    vec3 world_position;
 } vertex_output;
 
 #define COMMON_UNIFORM_BINDING_SET 1
 #include "common_uniforms.glsl"
-#include "vertex_uniforms.glsl"
-#include "per_instance_vertex_uniforms.glsl"
 
-vec3 deproject_point(vec3 point) {
-    vec4 deprojected_point = vertex_uniforms.inv_view_projection_matrix * vec4(point, 1.0);
-    return deprojected_point.xyz / deprojected_point.w;
-}
+// The ground plane is real geometry, so its depth comes from the rasterizer and it can be depth
+// tested against the opaque pass without writing gl_FragDepth. It's a fan of triangles around the
+// point under the camera, which keeps interpolated world positions precise close to the camera.
+// Reaches twice the far plane, anything further is clipped.
+#define GRID_EXTENT (2.0 * common_uniforms.far_plane)
 
 void main() {
-    const vec3 positions[] = {
-        vec3(-1, -1, 0),
-        vec3( 1, -1, 0),
-        vec3( 1,  1, 0),
-        vec3( 1,  1, 0),
-        vec3(-1,  1, 0),
-        vec3(-1, -1, 0),
+    const vec2 corners[] = {
+        vec2(-1, -1),
+        vec2( 1, -1),
+        vec2( 1,  1),
+        vec2(-1,  1),
     };
 
-    vec4 position = vec4(positions[gl_VertexIndex], 1);
-    vertex_output.near = deproject_point(vec3(position.xy, 0.0));
-    vertex_output.far  = deproject_point(vec3(position.xy, 1.0));
+    vec3 camera_position = common_uniforms.inv_view_matrix[3].xyz;
+
+    int triangle = gl_VertexIndex / 3;
+    int corner = gl_VertexIndex % 3;
 
-    gl_Position = position;
-}
\ No newline at end of file
+    vec2 offset = corner == 0 ? vec2(0) : corners[(triangle + corner - 1) % 4] * GRID_EXTENT;
+    vec3 world_position = vec3(camera_position.x + offset.x, 0.0, camera_position.z + offset.y);
+
+    vertex_output.world_position = world_position;
+    gl_Position = common_uniforms.view_projection_matrix * vec4(world_position, 1.0);
+}
@@ -8,12 +8,31 @@
 #include "HandmadeMath.h"
 
 #include "objzero.h"
+#include "obj_loader.h"
+
+#include "gpu_resources.h"
+#include "shader_bundle.h"
+#include "soft_rasterizer.h"
 
 #define NS_PER_UPDATE (1.0 / 60.0 * SDL_NS_PER_SECOND)
 
+//  If the simulation falls further behind than this (debugger break, window drag), skip ahead instead of catching up
+#define MAX_UPDATE_LAG_NS (SDL_NS_PER_SECOND / 4)
+
+//  Draw lists are split across recording threads, but only once each thread gets enough draws to be worth a command buffer
+#define MAX_RECORDING_WORKERS 7
+#define MIN_DRAWS_PER_RECORDING_THREAD 1024
+
+//  Override with --gpu-budget-mb
+#define DEFAULT_GPU_MEMORY_BUDGET_MB 1024
+
+//  Shaders read it from the common uniforms, the grid's extent is derived from it
+#define FAR_PLANE 10000.0f
+
 typedef struct CommonUniformBlock {
     float time;
     float instance_count;
+    float far_plane;
 
     HMM_Mat4 view_matrix;
     HMM_Mat4 projection_matrix;
@@ -36,11 +55,294 @@ typedef struct FragmentUniformBlock {
     HMM_Vec3 light_direction;
 } FragmentUniformBlock;
 
+typedef struct PerInstanceFragmentUniformBlock {
+    HMM_Vec4 color;
+} PerInstanceFragmentUniformBlock;
+
 typedef enum InputMode {
     INPUT_MODE_NONE,
     INPUT_MODE_CAMERA,
 } InputMode;
 
+typedef enum InputKey {
+    INPUT_KEY_FORWARD  = 1 << 0,
+    INPUT_KEY_BACKWARD = 1 << 1,
+    INPUT_KEY_LEFT     = 1 << 2,
+    INPUT_KEY_RIGHT    = 1 << 3,
+    INPUT_KEY_DOWN     = 1 << 4,
+    INPUT_KEY_UP       = 1 << 5,
+} InputKey;
+
+//  Input as sampled on the main thread. Mouse motion is a running total, so the
+//  simulation thread can diff against the last total it consumed and never lose motion
+//  between snapshots.
+typedef struct InputSnapshot {
+    InputMode input_mode;
+    Uint32    keys;
+    HMM_Vec2  mouse_total;
+} InputSnapshot;
+
+//  Input consumed by a single simulation step
+typedef struct UpdateInput {
+    InputMode input_mode;
+    Uint32    keys;
+    HMM_Vec2  mouse_delta;
+} UpdateInput;
+
+//  Lock free single producer / single consumer triple buffer. Only indices are swapped,
+//  callers keep the actual slots in an array of 3 alongside it.
+//  The writer always owns write_index, the reader always owns read_index, and the third
+//  slot is parked in shared_index, tagged with TRIPLE_BUFFER_FRESH when it holds data
+//  the reader has not seen yet.
+#define TRIPLE_BUFFER_FRESH 0x4
+
+typedef struct TripleBuffer {
+    SDL_AtomicInt shared_index;
+    int write_index;
+    int read_index;
+} TripleBuffer;
+
+void InitTripleBuffer(TripleBuffer *buffer) {
+    buffer->write_index = 0;
+    SDL_SetAtomicInt(&buffer->shared_index, 1);
+    buffer->read_index = 2;
+}
+
+//  Hands the write slot to the reader, returns the slot to write next
+int PublishTripleBuffer(TripleBuffer *buffer) {
+    int previous_shared_index = SDL_SetAtomicInt(&buffer->shared_index, buffer->write_index | TRIPLE_BUFFER_FRESH);
+    buffer->write_index = previous_shared_index & ~TRIPLE_BUFFER_FRESH;
+    return buffer->write_index;
+}
+
+//  Takes the most recently published slot if there is one, returns the slot to read
+int AcquireTripleBuffer(TripleBuffer *buffer) {
+    if (SDL_GetAtomicInt(&buffer->shared_index) & TRIPLE_BUFFER_FRESH) {
+        int previous_shared_index = SDL_SetAtomicInt(&buffer->shared_index, buffer->read_index);
+        buffer->read_index = previous_shared_index & ~TRIPLE_BUFFER_FRESH;
+    }
+
+    return buffer->read_index;
+}
+
+//  Replay logs hold the input to every simulation step, so a recorded fly-through can be fed to
+//  Update again exactly, e.g. to compare frame times before and after an engine change.
+//  The header is the magic, the version and the step length in nanoseconds, all little endian.
+//  Each step after it is a single byte of flags, followed by the mouse delta as two floats only
+//  when the mouse moved, so idle steps cost one byte.
+#define REPLAY_MAGIC   SDL_FOURCC('R', 'P', 'L', 'Y')
+#define REPLAY_VERSION 1
+
+#define REPLAY_STEP_KEYS        0x3f
+#define REPLAY_STEP_CAMERA_MODE 0x40
+#define REPLAY_STEP_MOUSE_DELTA 0x80
+
+SDL_COMPILE_TIME_ASSERT(replay_step_keys, (INPUT_KEY_FORWARD | INPUT_KEY_BACKWARD | INPUT_KEY_LEFT | INPUT_KEY_RIGHT | INPUT_KEY_DOWN | INPUT_KEY_UP) == REPLAY_STEP_KEYS);
+
+typedef struct ReplayLog {
+    SDL_IOStream *stream;
+
+    //  Replays are loaded up front, so the simulation thread never waits on the disk
+    void *data;
+} ReplayLog;
+
+//  Returns false on write errors
+bool CloseReplayLog(ReplayLog *log) {
+    bool closed = !log->stream || SDL_CloseIO(log->stream);
+    SDL_free(log->data);
+    SDL_zerop(log);
+    return closed;
+}
+
+bool BeginReplayRecording(ReplayLog *log, const char *filename) {
+    log->stream = SDL_IOFromFile(filename, "wb");
+    if (!log->stream) {
+        return false;
+    }
+
+    bool wrote_header =
+        SDL_WriteU32LE(log->stream, REPLAY_MAGIC) &&
+        SDL_WriteU32LE(log->stream, REPLAY_VERSION) &&
+        SDL_WriteU64LE(log->stream, (Uint64) NS_PER_UPDATE);
+
+    if (!wrote_header) {
+        CloseReplayLog(log);
+        return false;
+    }
+
+    return true;
+}
+
+bool WriteReplayStep(ReplayLog *log, const UpdateInput *input) {
+    bool has_mouse_delta = input->mouse_delta.X != 0 || input->mouse_delta.Y != 0;
+
+    Uint8 flags = input->keys & REPLAY_STEP_KEYS;
+    if (input->input_mode == INPUT_MODE_CAMERA) { flags |= REPLAY_STEP_CAMERA_MODE; }
+    if (has_mouse_delta)                        { flags |= REPLAY_STEP_MOUSE_DELTA; }
+
+    if (!SDL_WriteU8(log->stream, flags)) {
+        return false;
+    }
+
+    if (has_mouse_delta) {
+        Uint32 x, y;
+        SDL_memcpy(&x, &input->mouse_delta.X, sizeof(x));
+        SDL_memcpy(&y, &input->mouse_delta.Y, sizeof(y));
+        return SDL_WriteU32LE(log->stream, x) && SDL_WriteU32LE(log->stream, y);
+    }
+
+    return true;
+}
+
+bool LoadReplay(ReplayLog *log, const char *filename) {
+    size_t size;
+    log->data = SDL_LoadFile(filename, &size);
+    if (!log->data) {
+        return false;
+    }
+
+    log->stream = SDL_IOFromConstMem(log->data, size);
+    if (!log->stream) {
+        CloseReplayLog(log);
+        return false;
+    }
+
+    Uint32 magic, version;
+    Uint64 ns_per_update;
+    bool read_header =
+        SDL_ReadU32LE(log->stream, &magic) &&
+        SDL_ReadU32LE(log->stream, &version) &&
+        SDL_ReadU64LE(log->stream, &ns_per_update);
+
+    if (!read_header || magic != REPLAY_MAGIC) {
+        CloseReplayLog(log);
+        return SDL_SetError("\"%s\" is not a replay log", filename);
+    }
+
+    if (version != REPLAY_VERSION) {
+        CloseReplayLog(log);
+        return SDL_SetError("\"%s\" is replay log version %u, expected %u", filename, version, REPLAY_VERSION);
+    }
+
+    //  The steps only replay the same simulation at the same timestep
+    if (ns_per_update != (Uint64) NS_PER_UPDATE) {
+        CloseReplayLog(log);
+        return SDL_SetError("\"%s\" was recorded with %llu ns steps, expected %llu", filename, (unsigned long long) ns_per_update, (unsigned long long) NS_PER_UPDATE);
+    }
+
+    return true;
+}
+
+//  Returns false at the end of the log
+bool ReadReplayStep(ReplayLog *log, UpdateInput *input) {
+    Uint8 flags;
+    if (!SDL_ReadU8(log->stream, &flags)) {
+        return false;
+    }
+
+    input->input_mode  = (flags & REPLAY_STEP_CAMERA_MODE) ? INPUT_MODE_CAMERA : INPUT_MODE_NONE;
+    input->keys        = flags & REPLAY_STEP_KEYS;
+    input->mouse_delta = HMM_V2(0, 0);
+
+    if (flags & REPLAY_STEP_MOUSE_DELTA) {
+        Uint32 x, y;
+        if (!SDL_ReadU32LE(log->stream, &x) || !SDL_ReadU32LE(log->stream, &y)) {
+            return false;
+        }
+
+        SDL_memcpy(&input->mouse_delta.X, &x, sizeof(x));
+        SDL_memcpy(&input->mouse_delta.Y, &y, sizeof(y));
+    }
+
+    return true;
+}
+
+//  Time from the start of each rendered frame to the start of the next
+typedef struct FrameTimes {
+    Uint64 *frame_ns;
+    Uint32 num_frames;
+    Uint32 capacity;
+
+    Uint64 last_frame_start_ns;
+} FrameTimes;
+
+bool PushFrameTime(FrameTimes *frame_times, Uint64 frame_start_ns) {
+    if (frame_times->last_frame_start_ns) {
+        if (frame_times->num_frames == frame_times->capacity) {
+            Uint32 capacity = frame_times->capacity ? frame_times->capacity * 2 : 1024;
+            Uint64 *frame_ns = SDL_realloc(frame_times->frame_ns, sizeof(Uint64) * capacity);
+            if (!frame_ns) {
+                return false;
+            }
+
+            frame_times->frame_ns = frame_ns;
+            frame_times->capacity = capacity;
+        }
+
+        frame_times->frame_ns[frame_times->num_frames++] = frame_start_ns - frame_times->last_frame_start_ns;
+    }
+
+    frame_times->last_frame_start_ns = frame_start_ns;
+    return true;
+}
+
+int SDLCALL CompareFrameTimes(const void *a, const void *b) {
+    Uint64 frame_ns_a = *(const Uint64 *) a;
+    Uint64 frame_ns_b = *(const Uint64 *) b;
+    return (frame_ns_a > frame_ns_b) - (frame_ns_a < frame_ns_b);
+}
+
+//  Nearest rank percentile, frame_ns has to be sorted
+double FrameTimePercentileMs(const FrameTimes *frame_times, double percentile) {
+    Uint32 rank = (Uint32) SDL_ceil(percentile / 100.0 * frame_times->num_frames);
+    return frame_times->frame_ns[SDL_max(rank, 1) - 1] / (double) SDL_NS_PER_MS;
+}
+
+//  Writes every frame time in milliseconds, one per line in the order they were rendered, to filename
+//  if there is one. Then logs the distribution in one line, so runs are easy to diff.
+//  Sorts frame_ns in place.
+bool ReportFrameTimes(FrameTimes *frame_times, const char *filename) {
+    if (frame_times->num_frames == 0) {
+        return SDL_SetError("No frames were rendered");
+    }
+
+    bool saved = true;
+    if (filename) {
+        SDL_IOStream *stream = SDL_IOFromFile(filename, "w");
+        saved = stream != NULL;
+
+        for (Uint32 i = 0; saved && i < frame_times->num_frames; ++i) {
+            saved = SDL_IOprintf(stream, "%.4f\n", frame_times->frame_ns[i] / (double) SDL_NS_PER_MS) > 0;
+        }
+
+        if (stream) {
+            saved = SDL_CloseIO(stream) && saved;
+        }
+    }
+
+    Uint64 total_ns = 0;
+    for (Uint32 i = 0; i < frame_times->num_frames; ++i) {
+        total_ns += frame_times->frame_ns[i];
+    }
+
+    SDL_qsort(frame_times->frame_ns, frame_times->num_frames, sizeof(Uint64), CompareFrameTimes);
+
+    SDL_Log("Frame times over %u frames: mean %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms",
+        frame_times->num_frames,
+        total_ns / (double) frame_times->num_frames / SDL_NS_PER_MS,
+        FrameTimePercentileMs(frame_times, 50),
+        FrameTimePercentileMs(frame_times, 95),
+        FrameTimePercentileMs(frame_times, 99),
+        frame_times->frame_ns[frame_times->num_frames - 1] / (double) SDL_NS_PER_MS);
+
+    return saved;
+}
+
+void DestroyFrameTimes(FrameTimes *frame_times) {
+    SDL_free(frame_times->frame_ns);
+    SDL_zerop(frame_times);
+}
+
 typedef struct Transform {
     HMM_Vec3 location;
     HMM_Quat rotation;
@@ -97,21 +399,124 @@ typedef struct Camera {
 typedef struct Mesh {
     Entity base;
 
-    SDL_GPUBuffer *vertex_buffer;
-    SDL_GPUBuffer *index_buffer;
-    Uint32 num_indices;
+    //  Streamable, so it can be evicted from the GPU pools, then loaded again from filename
+    GpuMeshHandle gpu_mesh;
+    char *filename;
+
+    //  Refreshed by MakeMeshResident before every frame is recorded
+    GpuMeshLocation gpu_location;
+
+    //  Only kept on the CPU when rendering with the software rasterizer
+    ObjMesh model;
 } Mesh;
 
-void DestroyMesh(SDL_GPUDevice *gpu, Mesh *mesh) {
-    if (mesh->vertex_buffer) {
-        SDL_ReleaseGPUBuffer(gpu, mesh->vertex_buffer);
+void DestroyMesh(GpuResources *resources, Mesh *mesh) {
+    if (resources) {
+        ReleaseGpuMesh(resources, mesh->gpu_mesh);
+    }
+
+    DestroyObjMesh(&mesh->model);
+    SDL_free(mesh->filename);
+}
+
+//  Everything the render thread needs from one simulation step. Holds both the previous
+//  and current state, so the renderer can interpolate by however far it is into the next step.
+typedef struct SimSnapshot {
+    Uint64 nanoseconds_stepped;
+
+    float camera_fov;
+    Transform previous_camera_transform;
+    Transform current_camera_transform;
+
+    Transform previous_mesh_transform;
+    Transform current_mesh_transform;
+
+    HMM_Vec3 light_direction;
+} SimSnapshot;
+
+Transform InterpolateTransform(Transform from, Transform to, float alpha) {
+    Transform result;
+    result.location = HMM_LerpV3(from.location, alpha, to.location);
+    result.rotation = HMM_SLerp(from.rotation, alpha, to.rotation);
+    result.scale    = HMM_LerpV3(from.scale, alpha, to.scale);
+    return result;
+}
+
+typedef struct DrawCommand {
+    const Mesh *mesh;
+    PerInstanceVertexUniformBlock per_instance_vertex_uniforms;
+
+    //  Only used by transparent draws
+    PerInstanceFragmentUniformBlock per_instance_fragment_uniforms;
+} DrawCommand;
+
+typedef struct DrawList {
+    DrawCommand *commands;
+    Uint32 num_commands;
+    Uint32 capacity;
+} DrawList;
+
+bool PushDrawCommand(DrawList *draw_list, const Mesh *mesh, Transform transform) {
+    if (draw_list->num_commands == draw_list->capacity) {
+        Uint32 capacity = draw_list->capacity ? draw_list->capacity * 2 : 64;
+        DrawCommand *commands = SDL_realloc(draw_list->commands, sizeof(DrawCommand) * capacity);
+        if (!commands) {
+            return false;
+        }
+
+        draw_list->commands = commands;
+        draw_list->capacity = capacity;
     }
 
-    if (mesh->index_buffer) {
-        SDL_ReleaseGPUBuffer(gpu, mesh->index_buffer);
+    DrawCommand *command = &draw_list->commands[draw_list->num_commands++];
+    command->mesh = mesh;
+    command->per_instance_vertex_uniforms.model_matrix = CalcTransformMatrix(transform);
+    command->per_instance_vertex_uniforms.model_rotation_matrix = HMM_QToM4(transform.rotation);
+    command->per_instance_fragment_uniforms.color = HMM_V4(1, 1, 1, 1);
+    return true;
+}
+
+//  color is the tint and opacity
+bool PushTransparentDrawCommand(DrawList *draw_list, const Mesh *mesh, Transform transform, HMM_Vec4 color) {
+    if (!PushDrawCommand(draw_list, mesh, transform)) {
+        return false;
     }
+
+    draw_list->commands[draw_list->num_commands - 1].per_instance_fragment_uniforms.color = color;
+    return true;
+}
+
+void DestroyDrawList(DrawList *draw_list) {
+    SDL_free(draw_list->commands);
+    SDL_zerop(draw_list);
 }
 
+//  One draw list being recorded across several threads. Partition 0 is always recorded by the
+//  calling thread, partition N by recording_workers[N - 1]. Each partition records into its own
+//  command buffer, and they're submitted strictly in partition order.
+typedef struct RecordingJob {
+    const DrawList *draw_list;
+    Uint32 num_partitions;
+
+    SDL_GPUTexture *color_target;
+    SDL_GPUTexture *depth_target;
+
+    SDL_Mutex     *submit_mutex;
+    SDL_Condition *submit_condition;
+    Uint32 next_partition_to_submit;
+
+    SDL_Semaphore *finished;
+    SDL_AtomicInt failed;
+    SDL_AtomicInt quit;
+} RecordingJob;
+
+typedef struct RecordingWorker {
+    struct AppState *app_state;
+    SDL_Thread    *thread;
+    SDL_Semaphore *start;
+    Uint32 partition;
+} RecordingWorker;
+
 void InitCamera(Camera *camera) {
     Transform t = DEFAULT_TRANSFORM;
     t.location.Z = 5;
@@ -127,10 +532,32 @@ void InitCamera(Camera *camera) {
 typedef struct AppState {
     bool is_valid;
     Uint64 nanoseconds_since_init;
-    Uint64 nanoseconds_update_lag;
 
     InputMode input_mode;
 
+    //  Main thread -> simulation thread
+    HMM_Vec2 mouse_total;
+    TripleBuffer input_buffer;
+    InputSnapshot input_snapshots[3];
+
+    //  Simulation thread -> main thread
+    TripleBuffer sim_buffer;
+    SimSnapshot sim_snapshots[3];
+
+    SDL_Thread *sim_thread;
+    SDL_AtomicInt sim_running;
+
+    //  Set by --record-replay and --replay. Recording writes the input to every simulation step,
+    //  replaying feeds a recording to Update instead of live input, then sets replay_finished.
+    //  Both are owned by the simulation thread once it is started.
+    ReplayLog replay_recording;
+    ReplayLog replay;
+    SDL_AtomicInt replay_finished;
+
+    //  Owned by the simulation thread once it is started, except for the mesh GPU buffers
+    Uint64 nanoseconds_simulated;
+    HMM_Vec2 consumed_mouse_total;
+    HMM_Vec3 light_direction;
     Camera camera;
     Mesh mesh;
 
@@ -138,17 +565,48 @@ typedef struct AppState {
 
     CommonUniformBlock common_uniforms;
     VertexUniformBlock vertex_uniforms;
-    PerInstanceVertexUniformBlock per_instance_vertex_uniforms;
     FragmentUniformBlock fragment_uniforms;
-    // PerInstanceFragmentUniformBlock per_instance_fragment_uniforms;
 
+    DrawList draw_list;
+    DrawList transparent_draw_list;
+
+    RecordingJob recording_job;
+    RecordingWorker recording_workers[MAX_RECORDING_WORKERS];
+    Uint32 num_recording_workers;
+
+    //  Owns the mesh buffers and render targets below
+    GpuResources *gpu_resources;
+
+    //  Only rendered to when the draw list is recorded in parallel, since the swapchain texture
+    //  can only be used by the command buffer that acquired it
+    SDL_GPUTexture *scene_color_texture;
     SDL_GPUTexture *depth_texture;
 
+    //  Weighted blended OIT targets, resolved over the scene color by the composite pipeline
+    SDL_GPUTexture *accumulation_texture;
+    SDL_GPUTexture *revealage_texture;
+    SDL_GPUSampler *oit_sampler;
+
     SDL_Window    *window;
     SDL_GPUDevice *gpu;
 
     SDL_GPUGraphicsPipeline *grid_pipeline;
     SDL_GPUGraphicsPipeline *mesh_pipeline;
+    SDL_GPUGraphicsPipeline *transparent_pipeline;
+    SDL_GPUGraphicsPipeline *oit_composite_pipeline;
+
+    //  Used instead of the gpu when run with --software
+    SoftRasterizer *soft_rasterizer;
+    SoftMeshDraw *soft_draws;
+    Uint32 soft_draws_capacity;
+
+    //  Set by --screenshot, the first frame is saved here instead of presented
+    const char *screenshot_filename;
+
+    //  Measured with --frame-times, which names the file they're written to, and when replaying
+    bool measure_frame_times;
+    FrameTimes frame_times;
+    const char *frame_times_filename;
 } AppState;
 
 typedef struct VertexLayout {
@@ -157,191 +615,282 @@ typedef struct VertexLayout {
     HMM_Vec3 normal;
 } VertexLayout;
 
-SDL_AppResult CreateMeshFromFile(Mesh *mesh, SDL_GPUDevice *gpu, const char *filename) {
-    SDL_zerop(mesh);
-    mesh->base.transform = DEFAULT_TRANSFORM;
-
-    objzModel *model = objz_load(filename);
+int SDLCALL SimulationThread(void *data);
+int SDLCALL RecordingWorkerThread(void *data);
+SDL_AppResult Render(AppState *app_state);
 
-    SDL_GPUBufferCreateInfo vertex_buffer_descriptor = {
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-        .size = sizeof(VertexLayout) * model->numVertices,
-    };
+//  The OBJ loader's vertices are uploaded as is
+SDL_COMPILE_TIME_ASSERT(obj_vertex_size, sizeof(ObjVertex) == sizeof(VertexLayout));
+SDL_COMPILE_TIME_ASSERT(obj_vertex_position, offsetof(ObjVertex, position) == offsetof(VertexLayout, position));
+SDL_COMPILE_TIME_ASSERT(obj_vertex_uv, offsetof(ObjVertex, uv) == offsetof(VertexLayout, uv));
+SDL_COMPILE_TIME_ASSERT(obj_vertex_normal, offsetof(ObjVertex, normal) == offsetof(VertexLayout, normal));
 
-    mesh->vertex_buffer = SDL_CreateGPUBuffer(gpu, &vertex_buffer_descriptor);
-    if (!mesh->vertex_buffer) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create vertex buffer mesh \"%s\". %s", filename, SDL_GetError());
+//  Loads the mesh's file and uploads it into the GPU resource pools
+bool StreamMesh(Mesh *mesh, GpuResources *resources) {
+    ObjMesh model;
+    if (!LoadObj(&model, mesh->filename)) {
         return false;
     }
 
-    SDL_SetGPUBufferName(gpu, mesh->vertex_buffer, "vertex_buffer");
-
-    SDL_GPUBufferCreateInfo index_buffer_descriptor = {
-        .usage = SDL_GPU_BUFFERUSAGE_INDEX,
-        .size = sizeof(Uint32) * model->numIndices,
-    };
+    bool uploaded = UploadGpuMesh(resources, model.vertices, model.num_vertices, model.indices, model.num_indices, /*streamable =*/ true, &mesh->gpu_mesh);
+    DestroyObjMesh(&model);
 
-    mesh->index_buffer = SDL_CreateGPUBuffer(gpu, &index_buffer_descriptor);
-    if (!mesh->index_buffer) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create index buffer for mesh \"%s\". %s", filename, SDL_GetError());
+    if (!uploaded) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to upload mesh \"%s\". %s", mesh->filename, SDL_GetError());
         return false;
     }
 
-    SDL_SetGPUBufferName(gpu, mesh->index_buffer, "index_buffer");
+    return UseGpuMesh(resources, mesh->gpu_mesh, &mesh->gpu_location);
+}
 
-    // GPU Upload
-    {
-        SDL_GPUTransferBufferCreateInfo vertex_transfer_buffer_descriptor = {
-            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .size = sizeof(VertexLayout) * model->numVertices,
-        };
+//  Streams the mesh back in if it was evicted, and marks it as used this frame
+bool MakeMeshResident(GpuResources *resources, Mesh *mesh) {
+    if (UseGpuMesh(resources, mesh->gpu_mesh, &mesh->gpu_location)) {
+        return true;
+    }
 
-        SDL_GPUTransferBuffer *vertex_transfer_buffer = SDL_CreateGPUTransferBuffer(gpu, &vertex_transfer_buffer_descriptor);
-        if (!vertex_transfer_buffer) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create transfer buffer. %s", SDL_GetError());
-            return false;
-        }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Streaming evicted mesh \"%s\" back in", mesh->filename);
+    return StreamMesh(mesh, resources);
+}
 
-        {
-            VertexLayout *vertices = SDL_MapGPUTransferBuffer(gpu, vertex_transfer_buffer, false);
-            if (!vertices) {
-                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map transfer buffer. %s", SDL_GetError());
-                SDL_ReleaseGPUTransferBuffer(gpu, vertex_transfer_buffer);
-                return false;
-            }
+//  Without gpu resources the model stays on the CPU, for the software rasterizer
+SDL_AppResult CreateMeshFromFile(Mesh *mesh, GpuResources *resources, const char *filename) {
+    SDL_zerop(mesh);
+    mesh->base.transform = DEFAULT_TRANSFORM;
 
-            memcpy(vertices, model->vertices, vertex_buffer_descriptor.size);
+    mesh->filename = SDL_strdup(filename);
+    if (!mesh->filename) {
+        return false;
+    }
 
-            SDL_UnmapGPUTransferBuffer(gpu, vertex_transfer_buffer);
+    if (!resources) {
+        if (!LoadObj(&mesh->model, filename)) {
+            return false;
         }
 
-        mesh->num_indices = model->numIndices;
-
-        SDL_GPUTransferBufferCreateInfo index_transfer_buffer_descriptor = {
-            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .size = sizeof(Uint32) * mesh->num_indices,
-        };
-
-        SDL_GPUTransferBuffer *index_transfer_buffer = SDL_CreateGPUTransferBuffer(gpu, &index_transfer_buffer_descriptor);
-        if (!index_transfer_buffer) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create transfer buffer. %s", SDL_GetError());
+        if (!ValidateSoftMeshIndices(mesh->model.indices, mesh->model.num_indices, mesh->model.num_vertices)) {
+            DestroyObjMesh(&mesh->model);
             return false;
         }
 
-        {
-            Uint32 *indices = SDL_MapGPUTransferBuffer(gpu, index_transfer_buffer, false);
-            if (!indices) {
-                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map transfer buffer. %s", SDL_GetError());
-                SDL_ReleaseGPUTransferBuffer(gpu, index_transfer_buffer);
-                return false;
-            }
+        return true;
+    }
 
-            memcpy(indices, model->indices, index_buffer_descriptor.size);
+    return StreamMesh(mesh, resources);
+}
 
-            SDL_UnmapGPUTransferBuffer(gpu, index_transfer_buffer);
-        }
+typedef struct ShaderBundle {
+    void *data;
+    Sint64 size;
 
-        objz_destroy(model);
+    const ShaderBundleHeader *header;
+    const ShaderBundleEntry *entries;
+} ShaderBundle;
 
-        SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(gpu);
-        if (!command_buffer) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire command buffer. %s", SDL_GetError());
-            SDL_ReleaseGPUTransferBuffer(gpu, vertex_transfer_buffer);
-            SDL_ReleaseGPUTransferBuffer(gpu, index_transfer_buffer);
-            return false;
-        }
+void DestroyShaderBundle(ShaderBundle *bundle) {
+    SDL_free(bundle->data);
+    SDL_zerop(bundle);
+}
 
-        SDL_GPUCopyPass *pass = SDL_BeginGPUCopyPass(command_buffer);
+bool LoadShaderBundle(ShaderBundle *bundle, const char *filename) {
+    SDL_zerop(bundle);
 
-        SDL_GPUTransferBufferLocation source = {
-            .transfer_buffer = vertex_transfer_buffer,
-        };
+    SDL_IOStream *file_io = SDL_IOFromFile(filename, "rb");
+    if (!file_io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open \"%s\". %s", filename, SDL_GetError());
+        return false;
+    }
 
-        SDL_GPUBufferRegion destination = {
-            .buffer = mesh->vertex_buffer,
-            .size = vertex_buffer_descriptor.size,
-        };
+    bundle->size = SDL_GetIOSize(file_io);
+    bundle->data = bundle->size > 0 ? SDL_malloc(bundle->size) : NULL;
+
+    size_t num_bytes_read = bundle->data ? SDL_ReadIO(file_io, bundle->data, bundle->size) : 0;
+    SDL_CloseIO(file_io);
 
-        SDL_UploadToGPUBuffer(pass, &source, &destination, false);
+    if (num_bytes_read < bundle->size || bundle->size < (Sint64) sizeof(ShaderBundleHeader)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read shader bundle \"%s\". %s", filename, SDL_GetError());
+        DestroyShaderBundle(bundle);
+        return false;
+    }
 
-        source = (SDL_GPUTransferBufferLocation) {
-            .transfer_buffer = index_transfer_buffer,
-        };
+    bundle->header = bundle->data;
+    bundle->entries = (const ShaderBundleEntry *) (bundle->header + 1);
 
-        destination = (SDL_GPUBufferRegion) {
-            .buffer = mesh->index_buffer,
-            .size = index_buffer_descriptor.size,
-        };
+    if (bundle->header->magic != SHADER_BUNDLE_MAGIC || bundle->header->version != SHADER_BUNDLE_VERSION) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "\"%s\" is not a version %d shader bundle.", filename, SHADER_BUNDLE_VERSION);
+        DestroyShaderBundle(bundle);
+        return false;
+    }
+
+    Sint64 entries_end = sizeof(ShaderBundleHeader) + sizeof(ShaderBundleEntry) * (Sint64) bundle->header->num_shaders;
+    bool valid = entries_end <= bundle->size;
 
-        SDL_UploadToGPUBuffer(pass, &source, &destination, false);
+    for (Uint32 i = 0; valid && i < bundle->header->num_shaders; ++i) {
+        const ShaderBundleEntry *entry = &bundle->entries[i];
+        valid = entry->code_offset >= entries_end && (Sint64) entry->code_offset + entry->code_size <= bundle->size;
+    }
+
+    if (!valid) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader bundle \"%s\" is truncated.", filename);
+        DestroyShaderBundle(bundle);
+        return false;
+    }
 
-        SDL_EndGPUCopyPass(pass);
+    return true;
+}
 
-        bool submitted_command_buffer = SDL_SubmitGPUCommandBuffer(command_buffer);
+//  A loaded index list, for comparing loaders. Triangles are identified by their first index.
+typedef struct ObjTriangles {
+    const VertexLayout *vertices;
+    const Uint32 *indices;
+} ObjTriangles;
 
-        SDL_ReleaseGPUTransferBuffer(gpu, vertex_transfer_buffer);
-        SDL_ReleaseGPUTransferBuffer(gpu, index_transfer_buffer);
+int CompareObjTriangle(const ObjTriangles *triangles_a, Uint32 first_index_a, const ObjTriangles *triangles_b, Uint32 first_index_b) {
+    for (Uint32 corner = 0; corner < 3; ++corner) {
+        const VertexLayout *vertex_a = &triangles_a->vertices[triangles_a->indices[first_index_a + corner]];
+        const VertexLayout *vertex_b = &triangles_b->vertices[triangles_b->indices[first_index_b + corner]];
 
-        if (!submitted_command_buffer) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit command buffer. %s", SDL_GetError());
-            return false;
+        int order = memcmp(vertex_a, vertex_b, sizeof(VertexLayout));
+        if (order != 0) {
+            return order;
         }
     }
 
-    return true;
+    return 0;
 }
 
-SDL_GPUShader *create_shader_from_file(SDL_GPUDevice *gpu, const char *filename, SDL_GPUShaderStage stage, Uint32 num_samplers, Uint32 num_storage_buffers, Uint32 num_storage_textures, Uint32 num_uniform_buffers) {
-    SDL_IOStream *file_io = SDL_IOFromFile(filename, "rb");
-    if (!file_io) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open \"%s\". %s", filename, SDL_GetError());
+int SDLCALL CompareSortedObjTriangles(void *userdata, const void *a, const void *b) {
+    const ObjTriangles *triangles = userdata;
+    return CompareObjTriangle(triangles, *(const Uint32 *) a, triangles, *(const Uint32 *) b);
+}
+
+//  Returns the first index of every triangle, sorted by the triangles' vertices, or NULL if out of memory
+Uint32 *SortObjTriangles(const ObjTriangles *triangles, Uint32 num_triangles) {
+    Uint32 *order = SDL_malloc(sizeof(Uint32) * SDL_max(num_triangles, 1));
+    if (!order) {
         return NULL;
     }
 
-    Sint64 bytecode_size = SDL_GetIOSize(file_io);
-    void *bytecode = SDL_malloc(bytecode_size);
+    for (Uint32 i = 0; i < num_triangles; ++i) {
+        order[i] = i * 3;
+    }
 
-    size_t num_bytes_read = SDL_ReadIO(file_io, bytecode, bytecode_size);
-    SDL_CloseIO(file_io);
+    SDL_qsort_r(order, num_triangles, sizeof(Uint32), CompareSortedObjTriangles, (void *) triangles);
+    return order;
+}
+
+//  Loads the file with both objzero and LoadObj, times them, and checks they produce the same
+//  triangles. Run with --compare-obj <file>.
+bool CompareObjLoaders(const char *filename) {
+    Uint64 start = SDL_GetTicksNS();
+    objzModel *reference = objz_load(filename);
+    Uint64 objzero_ns = SDL_GetTicksNS() - start;
+
+    if (!reference) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "objzero failed to load \"%s\".", filename);
+        return false;
+    }
+
+    start = SDL_GetTicksNS();
+    ObjMesh obj_mesh;
+    bool loaded = LoadObj(&obj_mesh, filename);
+    Uint64 obj_loader_ns = SDL_GetTicksNS() - start;
+
+    if (!loaded) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load \"%s\". %s", filename, SDL_GetError());
+        objz_destroy(reference);
+        return false;
+    }
+
+    SDL_Log("objzero: %u vertices, %u indices in %.1f ms", reference->numVertices, reference->numIndices, objzero_ns / (double) SDL_NS_PER_MS);
+    SDL_Log("LoadObj: %u vertices, %u indices in %.1f ms (%.2fx)", obj_mesh.num_vertices, obj_mesh.num_indices, obj_loader_ns / (double) SDL_NS_PER_MS, objzero_ns / (double) obj_loader_ns);
+
+    //  objzero regroups faces by material, so the index lists only line up for single material
+    //  models. Compare the triangles each loader draws instead, with both sorted by their vertices.
+    bool identical = reference->numIndices == obj_mesh.num_indices;
+    if (!identical) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Index count differs from objzero.");
+    }
+
+    ObjTriangles reference_triangles = { .vertices = reference->vertices, .indices = reference->indices };
+    ObjTriangles obj_triangles = { .vertices = (const VertexLayout *) obj_mesh.vertices, .indices = obj_mesh.indices };
+
+    Uint32 num_triangles = obj_mesh.num_indices / 3;
+    Uint32 *reference_order = identical ? SortObjTriangles(&reference_triangles, num_triangles) : NULL;
+    Uint32 *obj_order = identical ? SortObjTriangles(&obj_triangles, num_triangles) : NULL;
+
+    if (identical && (!reference_order || !obj_order)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate triangle lists.");
+        SDL_free(reference_order);
+        SDL_free(obj_order);
+        DestroyObjMesh(&obj_mesh);
+        objz_destroy(reference);
+        return false;
+    }
+
+    for (Uint32 i = 0; identical && i < num_triangles; ++i) {
+        if (CompareObjTriangle(&reference_triangles, reference_order[i], &obj_triangles, obj_order[i]) != 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Triangle at index %u differs from objzero.", obj_order[i]);
+            identical = false;
+        }
+    }
+
+    SDL_free(reference_order);
+    SDL_free(obj_order);
+
+    SDL_Log("\"%s\" %s objzero", filename, identical ? "matches" : "does not match");
+
+    DestroyObjMesh(&obj_mesh);
+    objz_destroy(reference);
+    return identical;
+}
 
-    if (num_bytes_read < bytecode_size) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read shader bytecode from file \"%s\". %s", filename, SDL_GetError());
+SDL_GPUShader *create_shader_from_bundle(SDL_GPUDevice *gpu, const ShaderBundle *bundle, const char *name) {
+    const ShaderBundleEntry *entry = NULL;
+    for (Uint32 i = 0; i < bundle->header->num_shaders; ++i) {
+        if (SDL_strncmp(bundle->entries[i].name, name, SHADER_BUNDLE_MAX_NAME_LENGTH) == 0) {
+            entry = &bundle->entries[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader \"%s\" is not in the shader bundle.", name);
         return NULL;
     }
 
     SDL_GPUShaderCreateInfo descriptor = {
-        .stage                  = stage,
+        .stage                  = entry->stage == SHADER_BUNDLE_STAGE_VERTEX ? SDL_GPU_SHADERSTAGE_VERTEX : SDL_GPU_SHADERSTAGE_FRAGMENT,
         .format                 = SDL_GPU_SHADERFORMAT_SPIRV,
-        .code                   = bytecode,
-        .code_size              = bytecode_size,
+        .code                   = (const Uint8 *) bundle->data + entry->code_offset,
+        .code_size              = entry->code_size,
         .entrypoint             = "main",
-        .num_samplers           = num_samplers,
-        .num_storage_buffers    = num_storage_buffers,
-        .num_storage_textures   = num_storage_textures,
-        .num_uniform_buffers    = num_uniform_buffers,
+        .num_samplers           = entry->num_samplers,
+        .num_storage_buffers    = entry->num_storage_buffers,
+        .num_storage_textures   = entry->num_storage_textures,
+        .num_uniform_buffers    = entry->num_uniform_buffers,
     };
 
     SDL_GPUShader *shader = SDL_CreateGPUShader(gpu, &descriptor);
-    SDL_free(bytecode);
-
     if (!shader) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader from file \"%s\". %s", filename, SDL_GetError());
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader \"%s\". %s", name, SDL_GetError());
         return NULL;
     }
 
     return shader;
 }
 
-bool create_grid_pipeline(AppState *app_state) {
-    SDL_GPUShader *vertex_shader = create_shader_from_file(app_state->gpu, "grid.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 0, 0, 3);
+//  Also creates the old fullscreen grid for --benchmark-fragments, which writes its own depth
+SDL_GPUGraphicsPipeline *create_grid_pipeline_from_shaders(AppState *app_state, const ShaderBundle *shader_bundle, const char *vertex_shader_name, const char *fragment_shader_name, bool write_depth) {
+    SDL_GPUShader *vertex_shader = create_shader_from_bundle(app_state->gpu, shader_bundle, vertex_shader_name);
     if (!vertex_shader) {
-        return false;
+        return NULL;
     }
 
-    SDL_GPUShader *fragment_shader = create_shader_from_file(app_state->gpu, "grid.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 0, 0, 0, 2);
+    SDL_GPUShader *fragment_shader = create_shader_from_bundle(app_state->gpu, shader_bundle, fragment_shader_name);
     if (!fragment_shader) {
         SDL_ReleaseGPUShader(app_state->gpu, vertex_shader);
-        return false;
+        return NULL;
     }
 
     SDL_GPUGraphicsPipelineCreateInfo pipeline_descriptor = {
@@ -367,7 +916,7 @@ bool create_grid_pipeline(AppState *app_state) {
         },
         .depth_stencil_state = {
             .enable_depth_test = true,
-            .enable_depth_write = true,
+            .enable_depth_write = write_depth,
             .compare_op = SDL_GPU_COMPAREOP_GREATER_OR_EQUAL,
         },
         .rasterizer_state = {
@@ -376,29 +925,38 @@ bool create_grid_pipeline(AppState *app_state) {
         },
     };
 
-    app_state->grid_pipeline = SDL_CreateGPUGraphicsPipeline(app_state->gpu, &pipeline_descriptor);
+    SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(app_state->gpu, &pipeline_descriptor);
 
     SDL_ReleaseGPUShader(app_state->gpu, fragment_shader);
     SDL_ReleaseGPUShader(app_state->gpu, vertex_shader);
 
-    if (!app_state->grid_pipeline) {
+    if (!pipeline) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create grid pipeline. %s", SDL_GetError());
-        return false;
+        return NULL;
     }
 
-    return true;
+    return pipeline;
 }
 
-bool create_mesh_pipeline(AppState *app_state) {
-    SDL_GPUShader *vertex_shader = create_shader_from_file(app_state->gpu, "base.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 0, 0, 3);
+bool create_grid_pipeline(AppState *app_state, const ShaderBundle *shader_bundle) {
+    //  Drawn after the opaque pass, tested against it but never written, so it blends over
+    //  whatever is behind it and early-Z rejects it wherever a mesh is in front
+    app_state->grid_pipeline = create_grid_pipeline_from_shaders(app_state, shader_bundle, "grid.vert", "grid.frag", /*write_depth =*/ false);
+    return app_state->grid_pipeline != NULL;
+}
+
+//  Transparent meshes only differ in their fragment shader, targets and depth writes. Also creates
+//  the opaque pipeline for --benchmark-fragments, whose fragment shader writes its own depth.
+SDL_GPUGraphicsPipeline *create_mesh_pipeline_from_shaders(AppState *app_state, const ShaderBundle *shader_bundle, const char *fragment_shader_name, bool transparent) {
+    SDL_GPUShader *vertex_shader = create_shader_from_bundle(app_state->gpu, shader_bundle, "base");
     if (!vertex_shader) {
-        return false;
+        return NULL;
     }
 
-    SDL_GPUShader *fragment_shader = create_shader_from_file(app_state->gpu, "color.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 0, 0, 0, 2);
+    SDL_GPUShader *fragment_shader = create_shader_from_bundle(app_state->gpu, shader_bundle, fragment_shader_name);
     if (!fragment_shader) {
         SDL_ReleaseGPUShader(app_state->gpu, vertex_shader);
-        return false;
+        return NULL;
     }
 
     SDL_GPUGraphicsPipelineCreateInfo pipeline_descriptor = {
@@ -409,15 +967,6 @@ bool create_mesh_pipeline(AppState *app_state) {
             .num_color_targets = 1,
             .color_target_descriptions = (SDL_GPUColorTargetDescription[]) {{
                 .format = SDL_GetGPUSwapchainTextureFormat(app_state->gpu, app_state->window),
-                .blend_state = {
-                    .enable_blend = true,
-                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
-					.color_blend_op = SDL_GPU_BLENDOP_ADD,
-					.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
-					.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
-					.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-					.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-                },
             }},
             .has_depth_stencil_target = true,
             .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
@@ -464,42 +1013,709 @@ bool create_mesh_pipeline(AppState *app_state) {
         },
     };
 
-    app_state->mesh_pipeline = SDL_CreateGPUGraphicsPipeline(app_state->gpu, &pipeline_descriptor);
+    if (transparent) {
+        pipeline_descriptor.target_info.num_color_targets = 2;
+        pipeline_descriptor.target_info.color_target_descriptions = (SDL_GPUColorTargetDescription[]) {
+            {
+                .format = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT,
+                .blend_state = {
+                    .enable_blend = true,
+                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                    .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                },
+            },
+            {
+                .format = SDL_GPU_TEXTUREFORMAT_R16_FLOAT,
+                .blend_state = {
+                    .enable_blend = true,
+                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .src_color_blendfactor = SDL_GPU_BLENDFACTOR_ZERO,
+                    .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO,
+                    .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_COLOR,
+                    .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                },
+            },
+        };
+        pipeline_descriptor.depth_stencil_state.enable_depth_write = false;
+    }
+
+    SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(app_state->gpu, &pipeline_descriptor);
 
     SDL_ReleaseGPUShader(app_state->gpu, fragment_shader);
     SDL_ReleaseGPUShader(app_state->gpu, vertex_shader);
 
+    if (!pipeline) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create %s mesh pipeline. %s", transparent ? "transparent" : "opaque", SDL_GetError());
+        return NULL;
+    }
+
+    return pipeline;
+}
+
+bool create_mesh_pipelines(AppState *app_state, const ShaderBundle *shader_bundle) {
+    app_state->mesh_pipeline = create_mesh_pipeline_from_shaders(app_state, shader_bundle, "color", /*transparent =*/ false);
     if (!app_state->mesh_pipeline) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create mesh pipeline. %s", SDL_GetError());
         return false;
     }
 
-    return true;
+    app_state->transparent_pipeline = create_mesh_pipeline_from_shaders(app_state, shader_bundle, "transparent", /*transparent =*/ true);
+    return app_state->transparent_pipeline != NULL;
 }
 
-void recreate_depth_texture(AppState *app_state) {
-    if (app_state->depth_texture) {
-        SDL_ReleaseGPUTexture(app_state->gpu, app_state->depth_texture);
-        app_state->depth_texture = NULL;
+bool create_oit_composite_pipeline(AppState *app_state, const ShaderBundle *shader_bundle) {
+    SDL_GPUShader *vertex_shader = create_shader_from_bundle(app_state->gpu, shader_bundle, "fullscreen");
+    if (!vertex_shader) {
+        return false;
     }
 
-    int width, height;
-    SDL_GetWindowSizeInPixels(app_state->window, &width, &height);
+    SDL_GPUShader *fragment_shader = create_shader_from_bundle(app_state->gpu, shader_bundle, "oit_composite");
+    if (!fragment_shader) {
+        SDL_ReleaseGPUShader(app_state->gpu, vertex_shader);
+        return false;
+    }
+
+    SDL_GPUGraphicsPipelineCreateInfo pipeline_descriptor = {
+        .vertex_shader   = vertex_shader,
+        .fragment_shader = fragment_shader,
+        .primitive_type  = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .target_info = {
+            .num_color_targets = 1,
+            .color_target_descriptions = (SDL_GPUColorTargetDescription[]) {{
+                .format = SDL_GetGPUSwapchainTextureFormat(app_state->gpu, app_state->window),
+                .blend_state = {
+                    .enable_blend = true,
+                    .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                    .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                    .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                    .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                    .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                },
+            }},
+        },
+        .rasterizer_state = {
+            .cull_mode  = SDL_GPU_CULLMODE_NONE,
+            .front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
+        },
+    };
+
+    app_state->oit_composite_pipeline = SDL_CreateGPUGraphicsPipeline(app_state->gpu, &pipeline_descriptor);
+
+    SDL_ReleaseGPUShader(app_state->gpu, fragment_shader);
+    SDL_ReleaseGPUShader(app_state->gpu, vertex_shader);
+
+    if (!app_state->oit_composite_pipeline) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create OIT composite pipeline. %s", SDL_GetError());
+        return false;
+    }
 
-    SDL_GPUTextureCreateInfo depth_texture_descriptor = {
+    //  The composite reads the targets with texelFetch, the sampler only has to exist
+    SDL_GPUSamplerCreateInfo sampler_descriptor = {
+        .min_filter     = SDL_GPU_FILTER_NEAREST,
+        .mag_filter     = SDL_GPU_FILTER_NEAREST,
+        .mipmap_mode    = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+    };
+
+    app_state->oit_sampler = SDL_CreateGPUSampler(app_state->gpu, &sampler_descriptor);
+    if (!app_state->oit_sampler) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create OIT sampler. %s", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+SDL_GPUTexture *create_render_target(GpuResources *resources, SDL_GPUTextureFormat format, SDL_GPUTextureUsageFlags usage, Uint32 width, Uint32 height, const char *name) {
+    SDL_GPUTextureCreateInfo texture_descriptor = {
         .type   = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-        .usage  = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
+        .format = format,
+        .usage  = usage,
         .width  = width,
         .height = height,
         .layer_count_or_depth = 1,
         .num_levels = 1,
     };
 
-    app_state->depth_texture = SDL_CreateGPUTexture(app_state->gpu, &depth_texture_descriptor);
+    return CreateGpuTexture(resources, GPU_MEMORY_RENDER_TARGETS, &texture_descriptor, name);
+}
+
+void release_render_targets(AppState *app_state) {
+    SDL_GPUTexture **render_targets[] = {
+        &app_state->depth_texture,
+        &app_state->scene_color_texture,
+        &app_state->accumulation_texture,
+        &app_state->revealage_texture,
+    };
+
+    for (int i = 0; i < SDL_arraysize(render_targets); ++i) {
+        if (*render_targets[i]) {
+            ReleaseGpuTexture(app_state->gpu_resources, *render_targets[i]);
+            *render_targets[i] = NULL;
+        }
+    }
+}
+
+bool create_render_targets(AppState *app_state, Uint32 width, Uint32 height) {
+    release_render_targets(app_state);
+
+    SDL_GPUTextureFormat swapchain_format = SDL_GetGPUSwapchainTextureFormat(app_state->gpu, app_state->window);
+    SDL_GPUTextureUsageFlags color_usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+
+    app_state->depth_texture        = create_render_target(app_state->gpu_resources, SDL_GPU_TEXTUREFORMAT_D16_UNORM, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET, width, height, "Depth Texture");
+    app_state->scene_color_texture  = create_render_target(app_state->gpu_resources, swapchain_format, color_usage, width, height, "Scene Color Texture");
+    app_state->accumulation_texture = create_render_target(app_state->gpu_resources, SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT, color_usage, width, height, "OIT Accumulation Texture");
+    app_state->revealage_texture    = create_render_target(app_state->gpu_resources, SDL_GPU_TEXTUREFORMAT_R16_FLOAT, color_usage, width, height, "OIT Revealage Texture");
+
+    return app_state->depth_texture && app_state->scene_color_texture && app_state->accumulation_texture && app_state->revealage_texture;
+}
+
+bool recreate_render_targets(AppState *app_state) {
+    int width, height;
+    SDL_GetWindowSizeInPixels(app_state->window, &width, &height);
+
+    if (app_state->soft_rasterizer) {
+        return ResizeSoftRasterizer(app_state->soft_rasterizer, width, height);
+    }
+
+    return create_render_targets(app_state, width, height);
+}
+
+void PushFrameUniforms(AppState *app_state, SDL_GPUCommandBuffer *command_buffer) {
+    SDL_PushGPUVertexUniformData(command_buffer, 0, &app_state->common_uniforms, sizeof(CommonUniformBlock));
+    SDL_PushGPUVertexUniformData(command_buffer, 1, &app_state->vertex_uniforms, sizeof(VertexUniformBlock));
+
+    SDL_PushGPUFragmentUniformData(command_buffer, 0, &app_state->common_uniforms, sizeof(CommonUniformBlock));
+    SDL_PushGPUFragmentUniformData(command_buffer, 1, &app_state->fragment_uniforms, sizeof(FragmentUniformBlock));
+}
+
+void RecordDrawsWithPipeline(SDL_GPUGraphicsPipeline *pipeline, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *pass, const DrawCommand *draws, Uint32 num_draws) {
+    SDL_BindGPUGraphicsPipeline(pass, pipeline);
+
+    //  Meshes share pooled buffers, so most draws don't need to rebind them
+    SDL_GPUBuffer *bound_vertex_buffer = NULL;
+    SDL_GPUBuffer *bound_index_buffer = NULL;
+    for (Uint32 i = 0; i < num_draws; ++i) {
+        const DrawCommand *draw = &draws[i];
+        const GpuMeshLocation *location = &draw->mesh->gpu_location;
+
+        if (location->vertex_buffer != bound_vertex_buffer) {
+            SDL_BindGPUVertexBuffers(pass, 0, (SDL_GPUBufferBinding[]) {{.buffer = location->vertex_buffer}}, 1);
+            bound_vertex_buffer = location->vertex_buffer;
+        }
+
+        if (location->index_buffer != bound_index_buffer) {
+            SDL_BindGPUIndexBuffer(pass, &(SDL_GPUBufferBinding) {.buffer = location->index_buffer}, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+            bound_index_buffer = location->index_buffer;
+        }
+
+        SDL_PushGPUVertexUniformData(command_buffer, 2, &draw->per_instance_vertex_uniforms, sizeof(PerInstanceVertexUniformBlock));
+        SDL_DrawGPUIndexedPrimitives(pass, location->num_indices, 1, location->first_index, location->first_vertex, 0);
+    }
+}
+
+void RecordDraws(AppState *app_state, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *pass, const DrawCommand *draws, Uint32 num_draws) {
+    RecordDrawsWithPipeline(app_state->mesh_pipeline, command_buffer, pass, draws, num_draws);
+}
+
+//  Must come after the opaque draws, it only tests against their depth
+void RecordGrid(AppState *app_state, SDL_GPURenderPass *pass) {
+    SDL_BindGPUGraphicsPipeline(pass, app_state->grid_pipeline);
+    SDL_DrawGPUPrimitives(pass, 12, 1, 0, 0);
+}
+
+void RecordTransparentDraws(AppState *app_state, SDL_GPUCommandBuffer *command_buffer, SDL_GPURenderPass *pass, const DrawCommand *draws, Uint32 num_draws) {
+    SDL_BindGPUGraphicsPipeline(pass, app_state->transparent_pipeline);
+
+    //  Meshes share pooled buffers, so most draws don't need to rebind them
+    SDL_GPUBuffer *bound_vertex_buffer = NULL;
+    SDL_GPUBuffer *bound_index_buffer = NULL;
+    for (Uint32 i = 0; i < num_draws; ++i) {
+        const DrawCommand *draw = &draws[i];
+        const GpuMeshLocation *location = &draw->mesh->gpu_location;
+
+        if (location->vertex_buffer != bound_vertex_buffer) {
+            SDL_BindGPUVertexBuffers(pass, 0, (SDL_GPUBufferBinding[]) {{.buffer = location->vertex_buffer}}, 1);
+            bound_vertex_buffer = location->vertex_buffer;
+        }
+
+        if (location->index_buffer != bound_index_buffer) {
+            SDL_BindGPUIndexBuffer(pass, &(SDL_GPUBufferBinding) {.buffer = location->index_buffer}, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+            bound_index_buffer = location->index_buffer;
+        }
+
+        SDL_PushGPUVertexUniformData(command_buffer, 2, &draw->per_instance_vertex_uniforms, sizeof(PerInstanceVertexUniformBlock));
+        SDL_PushGPUFragmentUniformData(command_buffer, 2, &draw->per_instance_fragment_uniforms, sizeof(PerInstanceFragmentUniformBlock));
+        SDL_DrawGPUIndexedPrimitives(pass, location->num_indices, 1, location->first_index, location->first_vertex, 0);
+    }
+}
+
+//  Weighted blended order independent transparency. Transparent draws accumulate, in any order,
+//  into the accumulation and revealage targets, tested against the opaque depth, which is then
+//  resolved over the color target with one fullscreen triangle.
+void RecordTransparency(AppState *app_state, SDL_GPUCommandBuffer *command_buffer, SDL_GPUTexture *color_target, const DrawList *draw_list) {
+    if (draw_list->num_commands == 0) {
+        return;
+    }
+
+    SDL_GPUColorTargetInfo oit_target_infos[] = {
+        {
+            .texture = app_state->accumulation_texture,
+            .clear_color = { 0.0f, 0.0f, 0.0f, 0.0f },
+            .load_op = SDL_GPU_LOADOP_CLEAR,
+            .store_op = SDL_GPU_STOREOP_STORE,
+        },
+        {
+            .texture = app_state->revealage_texture,
+            .clear_color = { 1.0f, 0.0f, 0.0f, 0.0f },
+            .load_op = SDL_GPU_LOADOP_CLEAR,
+            .store_op = SDL_GPU_STOREOP_STORE,
+        },
+    };
+
+    SDL_GPUDepthStencilTargetInfo depth_target_info = {
+        .texture = app_state->depth_texture,
+        .load_op = SDL_GPU_LOADOP_LOAD,
+        .store_op = SDL_GPU_STOREOP_STORE,
+    };
 
-    if (app_state->depth_texture) {
-        SDL_SetGPUTextureName(app_state->gpu, app_state->depth_texture, "Depth Texture");
+    SDL_GPURenderPass *pass = SDL_BeginGPURenderPass(command_buffer, oit_target_infos, SDL_arraysize(oit_target_infos), &depth_target_info);
+    if (pass) {
+        RecordTransparentDraws(app_state, command_buffer, pass, draw_list->commands, draw_list->num_commands);
+        SDL_EndGPURenderPass(pass);
+    }
+
+    SDL_GPUColorTargetInfo color_target_info = {
+        .texture = color_target,
+        .load_op = SDL_GPU_LOADOP_LOAD,
+        .store_op = SDL_GPU_STOREOP_STORE,
+    };
+
+    pass = SDL_BeginGPURenderPass(command_buffer, &color_target_info, 1, NULL);
+    if (pass) {
+        SDL_BindGPUGraphicsPipeline(pass, app_state->oit_composite_pipeline);
+        SDL_BindGPUFragmentSamplers(pass, 0, (SDL_GPUTextureSamplerBinding[]) {
+            { .texture = app_state->accumulation_texture, .sampler = app_state->oit_sampler },
+            { .texture = app_state->revealage_texture,    .sampler = app_state->oit_sampler },
+        }, 2);
+        SDL_DrawGPUPrimitives(pass, 3, 1, 0, 0);
+        SDL_EndGPURenderPass(pass);
+    }
+}
+
+//  Records one partition of the job's draw list into its own command buffer, then waits for its
+//  turn to submit. Always takes its turn, even on failure, so later partitions aren't left waiting.
+bool RecordPartition(AppState *app_state, RecordingJob *job, Uint32 partition) {
+    Uint32 first_draw = (Uint64) job->draw_list->num_commands * partition / job->num_partitions;
+    Uint32 end_draw   = (Uint64) job->draw_list->num_commands * (partition + 1) / job->num_partitions;
+
+    bool recorded = true;
+
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app_state->gpu);
+    if (command_buffer) {
+        PushFrameUniforms(app_state, command_buffer);
+
+        SDL_GPUColorTargetInfo color_target_info = {
+            .texture = job->color_target,
+            .load_op = SDL_GPU_LOADOP_LOAD,
+            .store_op = SDL_GPU_STOREOP_STORE,
+        };
+
+        SDL_GPUDepthStencilTargetInfo depth_target_info = {
+            .texture = job->depth_target,
+            .load_op = SDL_GPU_LOADOP_LOAD,
+            .store_op = SDL_GPU_STOREOP_STORE,
+        };
+
+        SDL_GPURenderPass *pass = SDL_BeginGPURenderPass(command_buffer, &color_target_info, 1, &depth_target_info);
+        if (pass) {
+            RecordDraws(app_state, command_buffer, pass, &job->draw_list->commands[first_draw], end_draw - first_draw);
+            SDL_EndGPURenderPass(pass);
+        }
+    } else {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire command buffer for draw partition %u. %s", partition, SDL_GetError());
+        recorded = false;
+    }
+
+    SDL_LockMutex(job->submit_mutex);
+    while (job->next_partition_to_submit != partition) {
+        SDL_WaitCondition(job->submit_condition, job->submit_mutex);
+    }
+    SDL_UnlockMutex(job->submit_mutex);
+
+    if (command_buffer && !SDL_SubmitGPUCommandBuffer(command_buffer)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit command buffer for draw partition %u. %s", partition, SDL_GetError());
+        recorded = false;
+    }
+
+    SDL_LockMutex(job->submit_mutex);
+    job->next_partition_to_submit += 1;
+    SDL_BroadcastCondition(job->submit_condition);
+    SDL_UnlockMutex(job->submit_mutex);
+
+    return recorded;
+}
+
+int SDLCALL RecordingWorkerThread(void *data) {
+    RecordingWorker *worker = data;
+    AppState *app_state = worker->app_state;
+    RecordingJob *job = &app_state->recording_job;
+
+    for (;;) {
+        SDL_WaitSemaphore(worker->start);
+        if (SDL_GetAtomicInt(&job->quit)) {
+            break;
+        }
+
+        if (!RecordPartition(app_state, job, worker->partition)) {
+            SDL_SetAtomicInt(&job->failed, 1);
+        }
+
+        SDL_SignalSemaphore(job->finished);
+    }
+
+    return 0;
+}
+
+bool CreateRecordingWorkers(AppState *app_state) {
+    RecordingJob *job = &app_state->recording_job;
+
+    job->submit_mutex = SDL_CreateMutex();
+    job->submit_condition = SDL_CreateCondition();
+    job->finished = SDL_CreateSemaphore(0);
+    if (!job->submit_mutex || !job->submit_condition || !job->finished) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create recording job sync objects. %s", SDL_GetError());
+        return false;
+    }
+
+    //  Leave a core for the simulation thread
+    int num_cores = SDL_GetNumLogicalCPUCores();
+    Uint32 num_workers = num_cores > 2 ? num_cores - 2 : 0;
+    num_workers = SDL_min(num_workers, MAX_RECORDING_WORKERS);
+
+    for (Uint32 i = 0; i < num_workers; ++i) {
+        RecordingWorker *worker = &app_state->recording_workers[i];
+        worker->app_state = app_state;
+        worker->partition = i + 1;
+
+        worker->start = SDL_CreateSemaphore(0);
+        if (!worker->start) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create recording worker semaphore. %s", SDL_GetError());
+            return false;
+        }
+
+        worker->thread = SDL_CreateThread(RecordingWorkerThread, "Recording Worker", worker);
+        if (!worker->thread) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create recording worker thread. %s", SDL_GetError());
+            SDL_DestroySemaphore(worker->start);
+            worker->start = NULL;
+            return false;
+        }
+
+        app_state->num_recording_workers += 1;
+    }
+
+    return true;
+}
+
+void DestroyRecordingWorkers(AppState *app_state) {
+    RecordingJob *job = &app_state->recording_job;
+
+    SDL_SetAtomicInt(&job->quit, 1);
+    for (Uint32 i = 0; i < app_state->num_recording_workers; ++i) {
+        SDL_SignalSemaphore(app_state->recording_workers[i].start);
+    }
+
+    for (Uint32 i = 0; i < app_state->num_recording_workers; ++i) {
+        RecordingWorker *worker = &app_state->recording_workers[i];
+        SDL_WaitThread(worker->thread, NULL);
+        SDL_DestroySemaphore(worker->start);
+    }
+
+    app_state->num_recording_workers = 0;
+
+    if (job->finished) {
+        SDL_DestroySemaphore(job->finished);
+    }
+
+    if (job->submit_condition) {
+        SDL_DestroyCondition(job->submit_condition);
+    }
+
+    if (job->submit_mutex) {
+        SDL_DestroyMutex(job->submit_mutex);
+    }
+}
+
+//  Records and submits the draw list over the existing contents of the targets, split across
+//  at most max_partitions threads. Returns once every command buffer has been submitted.
+bool RecordDrawList(AppState *app_state, const DrawList *draw_list, SDL_GPUTexture *color_target, SDL_GPUTexture *depth_target, Uint32 max_partitions) {
+    RecordingJob *job = &app_state->recording_job;
+
+    Uint32 num_partitions = draw_list->num_commands / MIN_DRAWS_PER_RECORDING_THREAD;
+    num_partitions = SDL_min(num_partitions, app_state->num_recording_workers + 1);
+    num_partitions = SDL_min(num_partitions, max_partitions);
+    num_partitions = SDL_max(num_partitions, 1);
+
+    job->draw_list = draw_list;
+    job->num_partitions = num_partitions;
+    job->color_target = color_target;
+    job->depth_target = depth_target;
+    job->next_partition_to_submit = 0;
+    SDL_SetAtomicInt(&job->failed, 0);
+
+    for (Uint32 i = 1; i < num_partitions; ++i) {
+        SDL_SignalSemaphore(app_state->recording_workers[i - 1].start);
+    }
+
+    bool recorded = RecordPartition(app_state, job, 0);
+
+    for (Uint32 i = 1; i < num_partitions; ++i) {
+        SDL_WaitSemaphore(job->finished);
+    }
+
+    return recorded && !SDL_GetAtomicInt(&job->failed);
+}
+
+void CalcFrameUniforms(AppState *app_state, Transform camera_transform, float fov, float aspect_ratio) {
+    HMM_Mat4 view_matrix = HMM_InvGeneralM4(CalcTransformMatrix(camera_transform));
+    HMM_Mat4 projection_matrix = HMM_Perspective_RH_NO(fov * HMM_DegToRad, aspect_ratio, 0.3f, FAR_PLANE);
+
+    //  Reverse Z in the projection itself, z' = w - z, so the rasterizer interpolates the reversed
+    //  depth and no shader has to write gl_FragDepth, which would disable early depth testing
+    for (int column = 0; column < 4; ++column) {
+        projection_matrix.Elements[column][2] = projection_matrix.Elements[column][3] - projection_matrix.Elements[column][2];
+    }
+    app_state->common_uniforms.far_plane = FAR_PLANE;
+    app_state->common_uniforms.view_matrix = view_matrix;
+    app_state->common_uniforms.inv_view_matrix = HMM_InvGeneralM4(view_matrix);
+    app_state->common_uniforms.projection_matrix = projection_matrix;
+    app_state->common_uniforms.inv_projection_matrix = HMM_InvGeneralM4(projection_matrix);
+    app_state->common_uniforms.view_projection_matrix = HMM_MulM4(projection_matrix, view_matrix);
+
+    app_state->vertex_uniforms.inv_view_projection_matrix = HMM_InvGeneralM4(app_state->common_uniforms.view_projection_matrix);
+}
+
+//  Times recording + submission of growing draw lists, single threaded versus split across the
+//  recording workers. Run with --benchmark-recording.
+void RunRecordingBenchmark(AppState *app_state) {
+    const Uint32 draw_counts[] = { 1024, 4096, 16384, 65536 };
+    const int num_iterations = 16;
+
+    int width, height;
+    SDL_GetWindowSizeInPixels(app_state->window, &width, &height);
+
+    CalcFrameUniforms(app_state, app_state->camera.base.transform, app_state->camera.fov, width / (float) height);
+    app_state->common_uniforms.instance_count = 1;
+    app_state->fragment_uniforms.light_direction = HMM_V3(0, -1, 0);
+
+    Uint32 max_partitions = app_state->num_recording_workers + 1;
+    SDL_Log("Recording benchmark, %u recording threads", max_partitions);
+
+    DrawList draw_list = { 0 };
+
+    for (int i = 0; i < SDL_arraysize(draw_counts); ++i) {
+        Uint32 num_draws = draw_counts[i];
+        Uint32 grid_size = (Uint32) SDL_ceilf(SDL_sqrtf((float) num_draws));
+
+        draw_list.num_commands = 0;
+        for (Uint32 draw = 0; draw < num_draws; ++draw) {
+            Transform transform = DEFAULT_TRANSFORM;
+            transform.location = HMM_V3((draw % grid_size) * 3.0f, 0, -(float) (draw / grid_size) * 3.0f);
+
+            if (!PushDrawCommand(&draw_list, &app_state->mesh, transform)) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow draw list to %u draws.", num_draws);
+                DestroyDrawList(&draw_list);
+                return;
+            }
+        }
+
+        Uint64 nanoseconds_recording[2] = { 0, 0 };
+        Uint32 partition_limits[2] = { 1, max_partitions };
+
+        for (int path = 0; path < 2; ++path) {
+            for (int iteration = 0; iteration < num_iterations; ++iteration) {
+                SDL_WaitForGPUIdle(app_state->gpu);
+
+                Uint64 start = SDL_GetTicksNS();
+                RecordDrawList(app_state, &draw_list, app_state->scene_color_texture, app_state->depth_texture, partition_limits[path]);
+                nanoseconds_recording[path] += SDL_GetTicksNS() - start;
+            }
+        }
+
+        SDL_WaitForGPUIdle(app_state->gpu);
+
+        double single_ms   = nanoseconds_recording[0] / (double) num_iterations / SDL_NS_PER_MS;
+        double parallel_ms = nanoseconds_recording[1] / (double) num_iterations / SDL_NS_PER_MS;
+        SDL_Log("%6u draws: single threaded %8.3f ms, parallel %8.3f ms (%.2fx)", num_draws, single_ms, parallel_ms, single_ms / parallel_ms);
+    }
+
+    DestroyDrawList(&draw_list);
+}
+
+//  Times 4K frames of opaque meshes and the grid, first as they were drawn before: fullscreen grid
+//  first, with it and the meshes writing gl_FragDepth. Then the current grid, before and after the
+//  meshes, and last with the transparent meshes on top.
+void TimeFragmentBenchmarkRuns(AppState *app_state, SDL_GPUGraphicsPipeline *baseline_grid_pipeline, SDL_GPUGraphicsPipeline *baseline_mesh_pipeline) {
+    const Uint32 width  = 3840;
+    const Uint32 height = 2160;
+    const Uint32 grid_size = 16;
+    //  The first iterations of each run are thrown away. They pay for pipeline creation the driver
+    //  deferred until first use, and for the GPU clocking up
+    const int num_warmup_iterations = 4;
+    const int num_iterations = 32;
+
+    if (!create_render_targets(app_state, width, height)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create 4K render targets. %s", SDL_GetError());
+        return;
+    }
+
+    CalcFrameUniforms(app_state, app_state->camera.base.transform, app_state->camera.fov, width / (float) height);
+    app_state->common_uniforms.instance_count = 1;
+    app_state->fragment_uniforms.light_direction = HMM_V3(0, -1, 0);
+
+    DrawList draw_list = { 0 };
+    DrawList transparent_draw_list = { 0 };
+
+    bool pushed_draws = true;
+    for (Uint32 draw = 0; draw < grid_size * grid_size; ++draw) {
+        Transform transform = DEFAULT_TRANSFORM;
+        transform.location = HMM_V3(((draw % grid_size) - grid_size * 0.5f) * 1.5f, 0, -(float) (draw / grid_size) * 1.5f);
+        pushed_draws = pushed_draws && PushDrawCommand(&draw_list, &app_state->mesh, transform);
+
+        transform.location.Y += 1.0f;
+        pushed_draws = pushed_draws && PushTransparentDrawCommand(&transparent_draw_list, &app_state->mesh, transform, HMM_V4(0.3f, 0.6f, 0.9f, 0.4f));
+    }
+
+    if (!pushed_draws) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow benchmark draw lists.");
+        DestroyDrawList(&draw_list);
+        DestroyDrawList(&transparent_draw_list);
+        return;
+    }
+
+    SDL_Log("Fragment benchmark, %ux%u, %u opaque and %u transparent draws", width, height, draw_list.num_commands, transparent_draw_list.num_commands);
+
+    const struct {
+        const char *name;
+        bool baseline;
+        bool grid_first;
+        bool transparency;
+    } runs[] = {
+        { "baseline, gl_FragDepth",  .baseline = true, .grid_first = true },
+        { "grid first",              .grid_first = true },
+        { "opaque first",            0 },
+        { "opaque first with OIT",   .transparency = true },
+    };
+
+    double baseline_ms = 0;
+    for (Uint32 run = 0; run < SDL_arraysize(runs); ++run) {
+        Uint64 nanoseconds_rendering = 0;
+
+        for (int iteration = 0; iteration < num_warmup_iterations + num_iterations; ++iteration) {
+            SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app_state->gpu);
+            if (!command_buffer) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire command buffer. %s", SDL_GetError());
+                DestroyDrawList(&draw_list);
+                DestroyDrawList(&transparent_draw_list);
+                return;
+            }
+
+            PushFrameUniforms(app_state, command_buffer);
+
+            SDL_GPUColorTargetInfo color_target_info = {
+                .texture = app_state->scene_color_texture,
+                .clear_color = { 0.2f, 0.2f, 0.25f, 1.0f },
+                .load_op = SDL_GPU_LOADOP_CLEAR,
+                .store_op = SDL_GPU_STOREOP_STORE,
+            };
+
+            SDL_GPUDepthStencilTargetInfo depth_target_info = {
+                .texture = app_state->depth_texture,
+                .clear_depth = 0.0f,
+                .load_op = SDL_GPU_LOADOP_CLEAR,
+                .store_op = SDL_GPU_STOREOP_STORE,
+            };
+
+            SDL_GPURenderPass *pass = SDL_BeginGPURenderPass(command_buffer, &color_target_info, 1, &depth_target_info);
+            if (pass) {
+                if (runs[run].baseline) {
+                    SDL_BindGPUGraphicsPipeline(pass, baseline_grid_pipeline);
+                    SDL_DrawGPUPrimitives(pass, 6, 1, 0, 0);
+                    RecordDrawsWithPipeline(baseline_mesh_pipeline, command_buffer, pass, draw_list.commands, draw_list.num_commands);
+                } else {
+                    if (runs[run].grid_first) {
+                        RecordGrid(app_state, pass);
+                    }
+
+                    RecordDraws(app_state, command_buffer, pass, draw_list.commands, draw_list.num_commands);
+
+                    if (!runs[run].grid_first) {
+                        RecordGrid(app_state, pass);
+                    }
+                }
+
+                SDL_EndGPURenderPass(pass);
+            }
+
+            if (runs[run].transparency) {
+                RecordTransparency(app_state, command_buffer, app_state->scene_color_texture, &transparent_draw_list);
+            }
+
+            Uint64 start = SDL_GetTicksNS();
+
+            SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+            if (fence) {
+                SDL_WaitForGPUFences(app_state->gpu, true, &fence, 1);
+                SDL_ReleaseGPUFence(app_state->gpu, fence);
+            }
+
+            if (iteration >= num_warmup_iterations) {
+                nanoseconds_rendering += SDL_GetTicksNS() - start;
+            }
+        }
+
+        double frame_ms = nanoseconds_rendering / (double) num_iterations / SDL_NS_PER_MS;
+        if (runs[run].baseline) {
+            baseline_ms = frame_ms;
+        }
+
+        SDL_Log("%-24s %8.3f ms per frame (%.2fx baseline)", runs[run].name, frame_ms, baseline_ms / frame_ms);
+    }
+
+    DestroyDrawList(&draw_list);
+    DestroyDrawList(&transparent_draw_list);
+}
+
+//  Run with --benchmark-fragments. The baseline pipelines only exist for the benchmark.
+void RunFragmentBenchmark(AppState *app_state) {
+    ShaderBundle shader_bundle;
+    if (!LoadShaderBundle(&shader_bundle, "shaders.bundle")) {
+        return;
+    }
+
+    SDL_GPUGraphicsPipeline *baseline_grid_pipeline = create_grid_pipeline_from_shaders(app_state, &shader_bundle, "baseline_grid.vert", "grid.frag.frag_depth", /*write_depth =*/ true);
+    SDL_GPUGraphicsPipeline *baseline_mesh_pipeline = create_mesh_pipeline_from_shaders(app_state, &shader_bundle, "color.frag_depth", /*transparent =*/ false);
+
+    DestroyShaderBundle(&shader_bundle);
+
+    if (baseline_grid_pipeline && baseline_mesh_pipeline) {
+        TimeFragmentBenchmarkRuns(app_state, baseline_grid_pipeline, baseline_mesh_pipeline);
+    }
+
+    if (baseline_mesh_pipeline) {
+        SDL_ReleaseGPUGraphicsPipeline(app_state->gpu, baseline_mesh_pipeline);
+    }
+
+    if (baseline_grid_pipeline) {
+        SDL_ReleaseGPUGraphicsPipeline(app_state->gpu, baseline_grid_pipeline);
     }
 }
 
@@ -508,18 +1724,64 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
     SDL_zerop(app_state);
     *appstate = app_state;
 
-    InitCamera(&app_state->camera);
+    InitCamera(&app_state->camera);
+
+    // {
+    //     Transform t = DEFAULT_TRANSFORM;
+    //     t.location.Z = 5;
+    //     t.location.Y = 1;
+
+    //     app_state->camera.base.transform = t;
+    // }
+
+    objz_setVertexFormat(sizeof(VertexLayout), offsetof(VertexLayout, position), offsetof(VertexLayout, uv), offsetof(VertexLayout, normal));
+    objz_setIndexFormat(OBJZ_INDEX_FORMAT_U32);
+
+    long gpu_budget_mb = DEFAULT_GPU_MEMORY_BUDGET_MB;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (SDL_strcmp(argv[i], "--compare-obj") == 0) {
+            return CompareObjLoaders(argv[i + 1]) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        }
+
+        if (SDL_strcmp(argv[i], "--screenshot") == 0) {
+            app_state->screenshot_filename = argv[i + 1];
+        }
+
+        if (SDL_strcmp(argv[i], "--gpu-budget-mb") == 0) {
+            gpu_budget_mb = SDL_strtol(argv[i + 1], NULL, 10);
+        }
+
+        if (SDL_strcmp(argv[i], "--record-replay") == 0) {
+            if (!BeginReplayRecording(&app_state->replay_recording, argv[i + 1])) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start recording replay \"%s\". %s", argv[i + 1], SDL_GetError());
+                return SDL_APP_FAILURE;
+            }
+
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Recording replay to \"%s\"", argv[i + 1]);
+        }
 
-    // {
-    //     Transform t = DEFAULT_TRANSFORM;
-    //     t.location.Z = 5;
-    //     t.location.Y = 1;
+        if (SDL_strcmp(argv[i], "--replay") == 0) {
+            if (!LoadReplay(&app_state->replay, argv[i + 1])) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load replay \"%s\". %s", argv[i + 1], SDL_GetError());
+                return SDL_APP_FAILURE;
+            }
 
-    //     app_state->camera.base.transform = t;
-    // }
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Replaying \"%s\"", argv[i + 1]);
+            app_state->measure_frame_times = true;
+        }
 
-    objz_setVertexFormat(sizeof(VertexLayout), offsetof(VertexLayout, position), offsetof(VertexLayout, uv), offsetof(VertexLayout, normal));
-    objz_setIndexFormat(OBJZ_INDEX_FORMAT_U32);
+        if (SDL_strcmp(argv[i], "--frame-times") == 0) {
+            app_state->frame_times_filename = argv[i + 1];
+            app_state->measure_frame_times = true;
+        }
+    }
+
+    bool use_software_rasterizer = false;
+    for (int i = 1; i < argc; ++i) {
+        if (SDL_strcmp(argv[i], "--software") == 0) {
+            use_software_rasterizer = true;
+        }
+    }
 
     bool init_successful = SDL_Init(SDL_INIT_VIDEO);
     if (!init_successful) {
@@ -527,13 +1789,29 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
         return SDL_APP_FAILURE;
     }
 
-    app_state->gpu = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, /*debug_mode =*/ true, /*name =*/ NULL);
-    if (!app_state->gpu) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create gpu device. %s", SDL_GetError());
-        return SDL_APP_FAILURE;
-    }
+    if (use_software_rasterizer) {
+        app_state->soft_rasterizer = CreateSoftRasterizer(/*num_threads =*/ 0);
+        if (!app_state->soft_rasterizer) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create software rasterizer. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Rendering with the software rasterizer");
+    } else {
+        app_state->gpu = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, /*debug_mode =*/ true, /*name =*/ NULL);
+        if (!app_state->gpu) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create gpu device. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Selected GPU backend \"%s\"", SDL_GetGPUDeviceDriver(app_state->gpu));
 
-    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Selected GPU backend \"%s\"", SDL_GetGPUDeviceDriver(app_state->gpu));
+        app_state->gpu_resources = CreateGpuResources(app_state->gpu, sizeof(VertexLayout), (Uint64) SDL_max(gpu_budget_mb, 1) * 1024 * 1024);
+        if (!app_state->gpu_resources) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create gpu resource manager.");
+            return SDL_APP_FAILURE;
+        }
+    }
 
     app_state->window = SDL_CreateWindow("SDL3 Grid", 1280, 720, SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIDDEN);
     if (!app_state->window) {
@@ -541,39 +1819,95 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
         return SDL_APP_FAILURE;
     }
 
-    bool claimed_window_for_gpu = SDL_ClaimWindowForGPUDevice(app_state->gpu, app_state->window);
-    if (!claimed_window_for_gpu) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to claim window for gpu device. %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+    if (app_state->gpu) {
+        bool claimed_window_for_gpu = SDL_ClaimWindowForGPUDevice(app_state->gpu, app_state->window);
+        if (!claimed_window_for_gpu) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to claim window for gpu device. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
     }
 
-    recreate_depth_texture(app_state);
-
-    if (!app_state->depth_texture) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create depth texture. %s", SDL_GetError());
+    bool created_render_targets = recreate_render_targets(app_state);
+    if (!created_render_targets) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create render targets. %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    bool mesh_loaded = CreateMeshFromFile(&app_state->mesh, app_state->gpu, "models\\burger.obj");
+    bool mesh_loaded = CreateMeshFromFile(&app_state->mesh, app_state->gpu_resources, "models\\burger.obj");
     if (!mesh_loaded) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load mesh \"models\\burger.obj\". %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    bool created_mesh_pipeline = create_mesh_pipeline(app_state);
-    if (!created_mesh_pipeline) {
-        return SDL_APP_FAILURE;
+    if (app_state->gpu_resources) {
+        LogGpuMemoryStats(app_state->gpu_resources);
     }
 
-    bool created_grid_pipeline = create_grid_pipeline(app_state);
-    if (!created_grid_pipeline) {
-        return SDL_APP_FAILURE;
+    if (app_state->gpu) {
+        ShaderBundle shader_bundle;
+        bool shader_bundle_loaded = LoadShaderBundle(&shader_bundle, "shaders.bundle");
+        if (!shader_bundle_loaded) {
+            return SDL_APP_FAILURE;
+        }
+
+        bool created_mesh_pipelines = create_mesh_pipelines(app_state, &shader_bundle);
+        bool created_grid_pipeline = created_mesh_pipelines && create_grid_pipeline(app_state, &shader_bundle);
+        bool created_oit_composite_pipeline = created_grid_pipeline && create_oit_composite_pipeline(app_state, &shader_bundle);
+
+        DestroyShaderBundle(&shader_bundle);
+
+        if (!created_oit_composite_pipeline) {
+            return SDL_APP_FAILURE;
+        }
+
+        bool created_recording_workers = CreateRecordingWorkers(app_state);
+        if (!created_recording_workers) {
+            return SDL_APP_FAILURE;
+        }
+
+        for (int i = 1; i < argc; ++i) {
+            if (SDL_strcmp(argv[i], "--benchmark-recording") == 0) {
+                RunRecordingBenchmark(app_state);
+                return SDL_APP_SUCCESS;
+            }
+
+            if (SDL_strcmp(argv[i], "--benchmark-fragments") == 0) {
+                RunFragmentBenchmark(app_state);
+                return SDL_APP_SUCCESS;
+            }
+        }
+
+        bool updated_swapchain_parameters = SDL_SetGPUSwapchainParameters(app_state->gpu, app_state->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_IMMEDIATE);
+        if (!updated_swapchain_parameters) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to update swapchain parameters. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
     }
 
-    bool updated_swapchain_parameters = SDL_SetGPUSwapchainParameters(app_state->gpu, app_state->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_IMMEDIATE);
-    if (!updated_swapchain_parameters) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to update swapchain parameters. %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+    app_state->light_direction = HMM_V3(0, -1, 0);
+
+    SimSnapshot initial_snapshot = {
+        .nanoseconds_stepped        = SDL_GetTicksNS(),
+        .camera_fov                 = app_state->camera.fov,
+        .previous_camera_transform  = app_state->camera.base.transform,
+        .current_camera_transform   = app_state->camera.base.transform,
+        .previous_mesh_transform    = app_state->mesh.base.transform,
+        .current_mesh_transform     = app_state->mesh.base.transform,
+        .light_direction            = app_state->light_direction,
+    };
+
+    for (int i = 0; i < SDL_arraysize(app_state->sim_snapshots); ++i) {
+        app_state->sim_snapshots[i] = initial_snapshot;
+    }
+
+    InitTripleBuffer(&app_state->sim_buffer);
+    InitTripleBuffer(&app_state->input_buffer);
+
+    //  Renders the initial state, before the simulation starts, so the image is deterministic.
+    //  The window is never shown, so this also works with SDL_VIDEO_DRIVER=offscreen.
+    if (app_state->screenshot_filename) {
+        app_state->nanoseconds_since_init = initial_snapshot.nanoseconds_stepped;
+        return Render(app_state);
     }
 
     bool window_shown = SDL_ShowWindow(app_state->window);
@@ -582,15 +1916,21 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
         return SDL_APP_FAILURE;
     }
 
+    SDL_SetAtomicInt(&app_state->sim_running, 1);
+    app_state->sim_thread = SDL_CreateThread(SimulationThread, "Simulation", app_state);
+    if (!app_state->sim_thread) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create simulation thread. %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
     app_state->nanoseconds_since_init = SDL_GetTicksNS();
     app_state->is_valid = true;
     return SDL_APP_CONTINUE;
 }
 
-void UpdateCamera(AppState *app_state, Camera *camera, float dt) {
-    if (app_state->input_mode == INPUT_MODE_CAMERA) {
-        HMM_Vec2 mouse_delta;
-        SDL_GetRelativeMouseState(&mouse_delta.X, &mouse_delta.Y);
+void UpdateCamera(Camera *camera, const UpdateInput *input, float dt) {
+    if (input->input_mode == INPUT_MODE_CAMERA) {
+        HMM_Vec2 mouse_delta = input->mouse_delta;
 
         if (HMM_LenSqrV2(mouse_delta) > 0) {
             HMM_Mat4 rotation = HMM_QToM4(camera->base.transform.rotation);
@@ -599,15 +1939,13 @@ void UpdateCamera(AppState *app_state, Camera *camera, float dt) {
             camera->base.transform.rotation = HMM_M4ToQ_RH(rotation);
         }
 
-        const bool *keys = SDL_GetKeyboardState(NULL);
-
         HMM_Vec3 movement_input = HMM_V3(0, 0, 0);
-        if (keys[SDL_SCANCODE_W])     { movement_input = HMM_AddV3(movement_input, HMM_V3( 0,  0, -1)); }
-        if (keys[SDL_SCANCODE_S])     { movement_input = HMM_AddV3(movement_input, HMM_V3( 0,  0,  1)); }
-        if (keys[SDL_SCANCODE_A])     { movement_input = HMM_AddV3(movement_input, HMM_V3(-1,  0,  0)); }
-        if (keys[SDL_SCANCODE_D])     { movement_input = HMM_AddV3(movement_input, HMM_V3( 1,  0,  0)); }
-        if (keys[SDL_SCANCODE_LCTRL]) { movement_input = HMM_AddV3(movement_input, HMM_V3( 0, -1,  0)); }
-        if (keys[SDL_SCANCODE_SPACE]) { movement_input = HMM_AddV3(movement_input, HMM_V3( 0,  1,  0)); }
+        if (input->keys & INPUT_KEY_FORWARD)  { movement_input = HMM_AddV3(movement_input, HMM_V3( 0,  0, -1)); }
+        if (input->keys & INPUT_KEY_BACKWARD) { movement_input = HMM_AddV3(movement_input, HMM_V3( 0,  0,  1)); }
+        if (input->keys & INPUT_KEY_LEFT)     { movement_input = HMM_AddV3(movement_input, HMM_V3(-1,  0,  0)); }
+        if (input->keys & INPUT_KEY_RIGHT)    { movement_input = HMM_AddV3(movement_input, HMM_V3( 1,  0,  0)); }
+        if (input->keys & INPUT_KEY_DOWN)     { movement_input = HMM_AddV3(movement_input, HMM_V3( 0, -1,  0)); }
+        if (input->keys & INPUT_KEY_UP)       { movement_input = HMM_AddV3(movement_input, HMM_V3( 0,  1,  0)); }
 
         if (HMM_LenSqrV3(movement_input) > 0) {
             movement_input = HMM_NormV3(movement_input);
@@ -619,12 +1957,12 @@ void UpdateCamera(AppState *app_state, Camera *camera, float dt) {
     }
 };
 
-SDL_AppResult Update(AppState *app_state, float dt) {
-    UpdateCamera(app_state, &app_state->camera, dt);
+SDL_AppResult Update(AppState *app_state, const UpdateInput *input, float dt) {
+    UpdateCamera(&app_state->camera, input, dt);
 
-    app_state->fragment_uniforms.light_direction = HMM_V3(0, -1, 0);
+    app_state->light_direction = HMM_V3(0, -1, 0);
 
-    float theta = app_state->nanoseconds_since_init / (double) SDL_NS_PER_SECOND * 45.0f * HMM_DegToRad;
+    float theta = app_state->nanoseconds_simulated / (double) SDL_NS_PER_SECOND * 45.0f * HMM_DegToRad;
 
     HMM_Vec3 *location = &app_state->mesh.base.transform.location;
     location->X = HMM_SinF(theta) * 2.0f;
@@ -633,9 +1971,235 @@ SDL_AppResult Update(AppState *app_state, float dt) {
     HMM_Quat *rotation = &app_state->mesh.base.transform.rotation;
     *rotation = HMM_M4ToQ_RH(HMM_Rotate_RH(theta, HMM_V3(0, 0, 1)));
 
+    app_state->nanoseconds_simulated += NS_PER_UPDATE;
+
+    return SDL_APP_CONTINUE;
+}
+
+//  Steps the simulation at a fixed NS_PER_UPDATE, independent of how fast the main thread renders.
+//  Input comes in, and state goes out, through lock free triple buffers.
+int SDLCALL SimulationThread(void *data) {
+    AppState *app_state = data;
+
+    Uint64 next_update_ns = SDL_GetTicksNS();
+
+    while (SDL_GetAtomicInt(&app_state->sim_running)) {
+        Uint64 now = SDL_GetTicksNS();
+        if (now < next_update_ns) {
+            SDL_DelayNS(next_update_ns - now);
+            continue;
+        }
+
+        if (now - next_update_ns > MAX_UPDATE_LAG_NS) {
+            next_update_ns = now;
+        }
+
+        UpdateInput input;
+        if (app_state->replay.stream) {
+            if (!ReadReplayStep(&app_state->replay, &input)) {
+                SDL_SetAtomicInt(&app_state->replay_finished, 1);
+                break;
+            }
+        } else {
+            const InputSnapshot *input_snapshot = &app_state->input_snapshots[AcquireTripleBuffer(&app_state->input_buffer)];
+
+            input = (UpdateInput) {
+                .input_mode  = input_snapshot->input_mode,
+                .keys        = input_snapshot->keys,
+                .mouse_delta = HMM_SubV2(input_snapshot->mouse_total, app_state->consumed_mouse_total),
+            };
+
+            app_state->consumed_mouse_total = input_snapshot->mouse_total;
+        }
+
+        //  Keeps whatever was recorded so far if writing fails
+        if (app_state->replay_recording.stream && !WriteReplayStep(&app_state->replay_recording, &input)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to record replay, recording stopped. %s", SDL_GetError());
+            CloseReplayLog(&app_state->replay_recording);
+        }
+
+        Transform previous_camera_transform = app_state->camera.base.transform;
+        Transform previous_mesh_transform   = app_state->mesh.base.transform;
+
+        Update(app_state, &input, NS_PER_UPDATE / (double) SDL_NS_PER_SECOND);
+
+        SimSnapshot *snapshot = &app_state->sim_snapshots[app_state->sim_buffer.write_index];
+        snapshot->nanoseconds_stepped       = next_update_ns;
+        snapshot->camera_fov                = app_state->camera.fov;
+        snapshot->previous_camera_transform = previous_camera_transform;
+        snapshot->current_camera_transform  = app_state->camera.base.transform;
+        snapshot->previous_mesh_transform   = previous_mesh_transform;
+        snapshot->current_mesh_transform    = app_state->mesh.base.transform;
+        snapshot->light_direction           = app_state->light_direction;
+        PublishTripleBuffer(&app_state->sim_buffer);
+
+        next_update_ns += NS_PER_UPDATE;
+    }
+
+    return 0;
+}
+
+//  Renders the draw list on the CPU, then either copies the result to the window surface or saves it
+SDL_AppResult RenderSoftware(AppState *app_state) {
+    const DrawList *draw_list = &app_state->draw_list;
+    const DrawList *transparent_draw_list = &app_state->transparent_draw_list;
+
+    //  Opaque draws, followed by the transparent ones
+    Uint32 num_soft_draws = draw_list->num_commands + transparent_draw_list->num_commands;
+    if (num_soft_draws > app_state->soft_draws_capacity) {
+        SoftMeshDraw *soft_draws = SDL_realloc(app_state->soft_draws, sizeof(SoftMeshDraw) * num_soft_draws);
+        if (!soft_draws) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow software draw list.");
+            return SDL_APP_FAILURE;
+        }
+
+        app_state->soft_draws = soft_draws;
+        app_state->soft_draws_capacity = num_soft_draws;
+    }
+
+    for (Uint32 i = 0; i < num_soft_draws; ++i) {
+        const DrawCommand *command = i < draw_list->num_commands ? &draw_list->commands[i] : &transparent_draw_list->commands[i - draw_list->num_commands];
+        app_state->soft_draws[i] = (SoftMeshDraw) {
+            .vertices              = command->mesh->model.vertices,
+            .num_vertices          = command->mesh->model.num_vertices,
+            .indices               = command->mesh->model.indices,
+            .num_indices           = command->mesh->model.num_indices,
+            .model_matrix          = command->per_instance_vertex_uniforms.model_matrix,
+            .model_rotation_matrix = command->per_instance_vertex_uniforms.model_rotation_matrix,
+            .color                 = command->per_instance_fragment_uniforms.color,
+        };
+    }
+
+    SoftFrame frame = {
+        .view_projection_matrix     = app_state->common_uniforms.view_projection_matrix,
+        .inv_view_projection_matrix = app_state->vertex_uniforms.inv_view_projection_matrix,
+        .light_direction            = app_state->fragment_uniforms.light_direction,
+        .clear_color                = HMM_V4(0.2f, 0.2f, 0.25f, 1.0f),
+        .draws                      = app_state->soft_draws,
+        .num_draws                  = draw_list->num_commands,
+        .transparent_draws          = &app_state->soft_draws[draw_list->num_commands],
+        .num_transparent_draws      = transparent_draw_list->num_commands,
+    };
+
+    if (!RenderSoftFrame(app_state->soft_rasterizer, &frame)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to render software frame. %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    Uint32 width, height, pitch;
+    const Uint32 *pixels = GetSoftColorBuffer(app_state->soft_rasterizer, &width, &height, &pitch);
+
+    SDL_Surface *frame_surface = SDL_CreateSurfaceFrom(width, height, SDL_PIXELFORMAT_RGBA32, (void *) pixels, pitch * sizeof(Uint32));
+    if (!frame_surface) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create frame surface. %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    if (app_state->screenshot_filename) {
+        bool saved = SDL_SaveBMP(frame_surface, app_state->screenshot_filename);
+        SDL_DestroySurface(frame_surface);
+
+        if (!saved) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to save screenshot \"%s\". %s", app_state->screenshot_filename, SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        return SDL_APP_SUCCESS;
+    }
+
+    SDL_Surface *window_surface = SDL_GetWindowSurface(app_state->window);
+    bool presented = window_surface &&
+        SDL_BlitSurface(frame_surface, NULL, window_surface, NULL) &&
+        SDL_UpdateWindowSurface(app_state->window);
+
+    SDL_DestroySurface(frame_surface);
+
+    if (!presented) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to present software frame. %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
     return SDL_APP_CONTINUE;
 }
 
+//  Reads back the scene color texture, waiting for the gpu to finish the frame, and saves it as a BMP
+bool SaveSceneColor(AppState *app_state, SDL_GPUCommandBuffer *command_buffer, const char *filename) {
+    SDL_PixelFormat pixel_format;
+    switch (SDL_GetGPUSwapchainTextureFormat(app_state->gpu, app_state->window)) {
+        case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB: pixel_format = SDL_PIXELFORMAT_RGBA32; break;
+        case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM:
+        case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM_SRGB: pixel_format = SDL_PIXELFORMAT_BGRA32; break;
+        default: {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unsupported swapchain format for screenshots.");
+            SDL_CancelGPUCommandBuffer(command_buffer);
+            return false;
+        }
+    }
+
+    int width, height;
+    SDL_GetWindowSizeInPixels(app_state->window, &width, &height);
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_descriptor = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+        .size = width * height * sizeof(Uint32),
+    };
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(app_state->gpu, &transfer_buffer_descriptor);
+    if (!transfer_buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create transfer buffer. %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(command_buffer);
+        return false;
+    }
+
+    SDL_GPUCopyPass *pass = SDL_BeginGPUCopyPass(command_buffer);
+
+    SDL_GPUTextureRegion source = {
+        .texture = app_state->scene_color_texture,
+        .w = width,
+        .h = height,
+        .d = 1,
+    };
+
+    SDL_GPUTextureTransferInfo destination = {
+        .transfer_buffer = transfer_buffer,
+    };
+
+    SDL_DownloadFromGPUTexture(pass, &source, &destination);
+
+    SDL_EndGPUCopyPass(pass);
+
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+    if (!fence) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit command buffer. %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(app_state->gpu, transfer_buffer);
+        return false;
+    }
+
+    bool saved = SDL_WaitForGPUFences(app_state->gpu, true, &fence, 1);
+    SDL_ReleaseGPUFence(app_state->gpu, fence);
+
+    void *pixels = saved ? SDL_MapGPUTransferBuffer(app_state->gpu, transfer_buffer, false) : NULL;
+    if (pixels) {
+        SDL_Surface *surface = SDL_CreateSurfaceFrom(width, height, pixel_format, pixels, width * sizeof(Uint32));
+        saved = surface && SDL_SaveBMP(surface, filename);
+        SDL_DestroySurface(surface);
+
+        SDL_UnmapGPUTransferBuffer(app_state->gpu, transfer_buffer);
+    } else {
+        saved = false;
+    }
+
+    SDL_ReleaseGPUTransferBuffer(app_state->gpu, transfer_buffer);
+
+    if (!saved) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to save screenshot \"%s\". %s", filename, SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
 SDL_AppResult Render(AppState *app_state) {
     //  Only render for first frame, when previous frame has finished;
     if (app_state->render_fence) {
@@ -647,6 +2211,22 @@ SDL_AppResult Render(AppState *app_state) {
         SDL_ReleaseGPUFence(app_state->gpu, app_state->render_fence);
     }
 
+    if (app_state->measure_frame_times && !PushFrameTime(&app_state->frame_times, app_state->nanoseconds_since_init)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow frame times.");
+        return SDL_APP_FAILURE;
+    }
+
+    //  Interpolate between the last two simulation steps by how far we are into the next one
+    const SimSnapshot *snapshot = &app_state->sim_snapshots[AcquireTripleBuffer(&app_state->sim_buffer)];
+
+    float alpha = ((double) app_state->nanoseconds_since_init - (double) snapshot->nanoseconds_stepped) / NS_PER_UPDATE;
+    alpha = HMM_Clamp(0.0f, alpha, 1.0f);
+
+    Transform camera_transform = InterpolateTransform(snapshot->previous_camera_transform, snapshot->current_camera_transform, alpha);
+    Transform mesh_transform   = InterpolateTransform(snapshot->previous_mesh_transform, snapshot->current_mesh_transform, alpha);
+
+    app_state->fragment_uniforms.light_direction = snapshot->light_direction;
+
     float time = (SDL_GetTicksNS() / (double) SDL_NS_PER_SECOND);
 
     int width, height;
@@ -659,15 +2239,33 @@ SDL_AppResult Render(AppState *app_state) {
 
     float phase = time * (HMM_PI * 2.0f) * 0.1f;
 
-    HMM_Mat4 view_matrix = HMM_InvGeneralM4(CalcTransformMatrix(app_state->camera.base.transform)); //HMM_LookAt_RH(HMM_V3(/*HMM_CosF(phase) * 5.0f*/0, /*HMM_SinF(phase) * 5.0f*/1, /*HMM_SinF(phase) * 5.0f*/3), HMM_V3(0, 0, 0), HMM_V3(0, 1, 0));
-    HMM_Mat4 projection_matrix = HMM_Perspective_RH_NO(app_state->camera.fov * HMM_DegToRad, aspect_ratio, 0.3f, 10000.0f);
-    app_state->common_uniforms.view_matrix = view_matrix;
-    app_state->common_uniforms.inv_view_matrix = HMM_InvGeneralM4(view_matrix);
-    app_state->common_uniforms.projection_matrix = projection_matrix;
-    app_state->common_uniforms.inv_projection_matrix = HMM_InvGeneralM4(projection_matrix);
-    app_state->common_uniforms.view_projection_matrix = HMM_MulM4(projection_matrix, view_matrix);
+    CalcFrameUniforms(app_state, camera_transform, snapshot->camera_fov, aspect_ratio);
 
-    app_state->vertex_uniforms.inv_view_projection_matrix = HMM_InvGeneralM4(app_state->common_uniforms.view_projection_matrix);
+    app_state->draw_list.num_commands = 0;
+    if (!PushDrawCommand(&app_state->draw_list, &app_state->mesh, mesh_transform)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to grow draw list.");
+        return SDL_APP_FAILURE;
+    }
+
+    //  Nothing in the scene is transparent yet, so the OIT passes are skipped.
+    //  --benchmark-fragments exercises them.
+    app_state->transparent_draw_list.num_commands = 0;
+
+    if (app_state->soft_rasterizer) {
+        return RenderSoftware(app_state);
+    }
+
+    BeginGpuResourcesFrame(app_state->gpu_resources);
+    if (!MakeMeshResident(app_state->gpu_resources, &app_state->mesh)) {
+        return SDL_APP_FAILURE;
+    }
+
+    //  Big draw lists are recorded across the recording workers into the scene color texture, which
+    //  is then blitted to the swapchain. Anything smaller goes straight to the swapchain.
+    bool record_in_parallel = app_state->num_recording_workers > 0 && app_state->draw_list.num_commands >= MIN_DRAWS_PER_RECORDING_THREAD * 2;
+
+    //  Screenshots are also rendered to the scene color texture, and read back instead of presented
+    bool render_to_scene_color = record_in_parallel || app_state->screenshot_filename;
 
     SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(app_state->gpu);
     if (!command_buffer) {
@@ -679,24 +2277,21 @@ SDL_AppResult Render(AppState *app_state) {
     Uint32 swapchain_width  = 0;
     Uint32 swapchain_height = 0;
 
-    bool acquired_swapchain_texture = SDL_AcquireGPUSwapchainTexture(command_buffer, app_state->window, &swapchain_texture, &swapchain_width, &swapchain_height);
-    if (!acquired_swapchain_texture) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire swapchain texture. %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+    if (!render_to_scene_color) {
+        bool acquired_swapchain_texture = SDL_AcquireGPUSwapchainTexture(command_buffer, app_state->window, &swapchain_texture, &swapchain_width, &swapchain_height);
+        if (!acquired_swapchain_texture) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire swapchain texture. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
     }
 
     int instance_count = 1;
     app_state->common_uniforms.instance_count = instance_count;
     app_state->common_uniforms.time = app_state->nanoseconds_since_init / (double) SDL_NS_PER_SECOND;
-    SDL_PushGPUVertexUniformData(command_buffer, 0, &app_state->common_uniforms, sizeof(CommonUniformBlock));
-    SDL_PushGPUVertexUniformData(command_buffer, 1, &app_state->vertex_uniforms, sizeof(VertexUniformBlock));
-
-    SDL_PushGPUFragmentUniformData(command_buffer, 0, &app_state->common_uniforms, sizeof(CommonUniformBlock));
-    SDL_PushGPUFragmentUniformData(command_buffer, 1, &app_state->fragment_uniforms, sizeof(FragmentUniformBlock));
-    //SDL_PushGPUFragmentUniformData(command_buffer, 2, &app_state->per_instance_fragment_uniforms, sizeof(PerInstanceFragmentUniformBlock));
+    PushFrameUniforms(app_state, command_buffer);
 
     SDL_GPUColorTargetInfo clear_target_info = {
-        .texture = swapchain_texture,
+        .texture = render_to_scene_color ? app_state->scene_color_texture : swapchain_texture,
         .clear_color = { 0.2f, 0.2f, 0.25f, 1.0f },
         .load_op = SDL_GPU_LOADOP_CLEAR,
         .store_op = SDL_GPU_STOREOP_STORE,
@@ -709,43 +2304,128 @@ SDL_AppResult Render(AppState *app_state) {
         .store_op = SDL_GPU_STOREOP_STORE,
     };
 
+    //  Opaque meshes go first, so the depth test rejects grid fragments behind them before shading
     SDL_GPURenderPass *pass = SDL_BeginGPURenderPass(command_buffer, &clear_target_info, 1, &depth_target_info);
     if (pass) {
-        SDL_BindGPUGraphicsPipeline(pass, app_state->grid_pipeline);
-        app_state->per_instance_vertex_uniforms.model_matrix = HMM_M4D(1);
-        app_state->per_instance_vertex_uniforms.model_rotation_matrix = HMM_M4D(1);
-        SDL_PushGPUVertexUniformData(command_buffer, 2, &app_state->per_instance_vertex_uniforms, sizeof(PerInstanceVertexUniformBlock));
-        SDL_DrawGPUPrimitives(pass, 6, 1, 0, 0);
-
-        SDL_BindGPUGraphicsPipeline(pass, app_state->mesh_pipeline);
-        SDL_BindGPUVertexBuffers(pass, 0, (SDL_GPUBufferBinding[]) {{.buffer = app_state->mesh.vertex_buffer}}, 1);
-        SDL_BindGPUIndexBuffer(pass, &(SDL_GPUBufferBinding) {.buffer = app_state->mesh.index_buffer}, SDL_GPU_INDEXELEMENTSIZE_32BIT);
-        app_state->per_instance_vertex_uniforms.model_matrix = CalcTransformMatrix(app_state->mesh.base.transform);
-        app_state->per_instance_vertex_uniforms.model_rotation_matrix = HMM_QToM4(app_state->mesh.base.transform.rotation);
-        SDL_PushGPUVertexUniformData(command_buffer, 2, &app_state->per_instance_vertex_uniforms, sizeof(PerInstanceVertexUniformBlock));
-        SDL_DrawGPUIndexedPrimitives(pass, app_state->mesh.num_indices, instance_count, 0, 0, 0);
+        if (!record_in_parallel) {
+            RecordDraws(app_state, command_buffer, pass, app_state->draw_list.commands, app_state->draw_list.num_commands);
+            RecordGrid(app_state, pass);
+        }
 
         SDL_EndGPURenderPass(pass);
     }
 
+    if (record_in_parallel) {
+        if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit command buffer. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        if (!RecordDrawList(app_state, &app_state->draw_list, app_state->scene_color_texture, app_state->depth_texture, MAX_RECORDING_WORKERS + 1)) {
+            return SDL_APP_FAILURE;
+        }
+
+        command_buffer = SDL_AcquireGPUCommandBuffer(app_state->gpu);
+        if (!command_buffer) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire command buffer. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        PushFrameUniforms(app_state, command_buffer);
+
+        SDL_GPUColorTargetInfo color_target_info = {
+            .texture = app_state->scene_color_texture,
+            .load_op = SDL_GPU_LOADOP_LOAD,
+            .store_op = SDL_GPU_STOREOP_STORE,
+        };
+
+        depth_target_info.load_op = SDL_GPU_LOADOP_LOAD;
+
+        pass = SDL_BeginGPURenderPass(command_buffer, &color_target_info, 1, &depth_target_info);
+        if (pass) {
+            RecordGrid(app_state, pass);
+            SDL_EndGPURenderPass(pass);
+        }
+    }
+
+    RecordTransparency(app_state, command_buffer, clear_target_info.texture, &app_state->transparent_draw_list);
+
+    if (app_state->screenshot_filename) {
+        return SaveSceneColor(app_state, command_buffer, app_state->screenshot_filename) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (record_in_parallel) {
+        bool acquired_swapchain_texture = SDL_AcquireGPUSwapchainTexture(command_buffer, app_state->window, &swapchain_texture, &swapchain_width, &swapchain_height);
+        if (!acquired_swapchain_texture) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to acquire swapchain texture. %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        if (swapchain_texture) {
+            int scene_width, scene_height;
+            SDL_GetWindowSizeInPixels(app_state->window, &scene_width, &scene_height);
+
+            SDL_GPUBlitInfo blit_info = {
+                .source = {
+                    .texture = app_state->scene_color_texture,
+                    .w = scene_width,
+                    .h = scene_height,
+                },
+                .destination = {
+                    .texture = swapchain_texture,
+                    .w = swapchain_width,
+                    .h = swapchain_height,
+                },
+                .load_op = SDL_GPU_LOADOP_DONT_CARE,
+                .filter = SDL_GPU_FILTER_NEAREST,
+            };
+
+            SDL_BlitGPUTexture(command_buffer, &blit_info);
+        }
+    }
+
     app_state->render_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
 
     return SDL_APP_CONTINUE;
 }
 
+//  Mouse and keyboard state can only be queried on the main thread, so sample it here and
+//  hand it to the simulation thread
+void SampleInput(AppState *app_state) {
+    InputSnapshot *input = &app_state->input_snapshots[app_state->input_buffer.write_index];
+    input->input_mode = app_state->input_mode;
+    input->keys = 0;
+
+    if (app_state->input_mode == INPUT_MODE_CAMERA) {
+        HMM_Vec2 mouse_delta;
+        SDL_GetRelativeMouseState(&mouse_delta.X, &mouse_delta.Y);
+        app_state->mouse_total = HMM_AddV2(app_state->mouse_total, mouse_delta);
+
+        const bool *keys = SDL_GetKeyboardState(NULL);
+        if (keys[SDL_SCANCODE_W])     { input->keys |= INPUT_KEY_FORWARD; }
+        if (keys[SDL_SCANCODE_S])     { input->keys |= INPUT_KEY_BACKWARD; }
+        if (keys[SDL_SCANCODE_A])     { input->keys |= INPUT_KEY_LEFT; }
+        if (keys[SDL_SCANCODE_D])     { input->keys |= INPUT_KEY_RIGHT; }
+        if (keys[SDL_SCANCODE_LCTRL]) { input->keys |= INPUT_KEY_DOWN; }
+        if (keys[SDL_SCANCODE_SPACE]) { input->keys |= INPUT_KEY_UP; }
+    }
+
+    input->mouse_total = app_state->mouse_total;
+
+    PublishTripleBuffer(&app_state->input_buffer);
+}
+
 SDL_AppResult SDL_AppIterate(void *appstate) {
     AppState *app_state = appstate;
 
-    Uint64 nanoseconds_since_init = SDL_GetTicksNS();
-    Uint64 nanosecond_delta = nanoseconds_since_init - app_state->nanoseconds_since_init;
-    app_state->nanoseconds_since_init = nanoseconds_since_init;
-    app_state->nanoseconds_update_lag += nanosecond_delta;
-
-    while (app_state->nanoseconds_update_lag >= NS_PER_UPDATE) {
-        Update(app_state, NS_PER_UPDATE / (double) SDL_NS_PER_SECOND);
-        app_state->nanoseconds_update_lag -= NS_PER_UPDATE;
+    if (SDL_GetAtomicInt(&app_state->replay_finished)) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Replay finished");
+        return SDL_APP_SUCCESS;
     }
 
+    app_state->nanoseconds_since_init = SDL_GetTicksNS();
+
+    SampleInput(app_state);
     Render(app_state);
 
     return SDL_APP_CONTINUE;
@@ -786,8 +2466,8 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
     }
 
     if (event->type == SDL_EVENT_WINDOW_RESIZED) {
-        recreate_depth_texture(app_state);
-        if (!app_state->depth_texture) {
+        if (!recreate_render_targets(app_state)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to recreate render targets. %s", SDL_GetError());
             return SDL_APP_FAILURE;
         }
     }
@@ -797,7 +2477,28 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
     AppState *app_state = appstate;
 
-    SDL_WaitForGPUIdle(app_state->gpu);
+    if (app_state->sim_thread) {
+        SDL_SetAtomicInt(&app_state->sim_running, 0);
+        SDL_WaitThread(app_state->sim_thread, NULL);
+    }
+
+    if (!CloseReplayLog(&app_state->replay_recording)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write replay. %s", SDL_GetError());
+    }
+
+    CloseReplayLog(&app_state->replay);
+
+    if (app_state->measure_frame_times && !ReportFrameTimes(&app_state->frame_times, app_state->frame_times_filename)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to report frame times. %s", SDL_GetError());
+    }
+
+    DestroyFrameTimes(&app_state->frame_times);
+
+    DestroyRecordingWorkers(app_state);
+
+    if (app_state->gpu) {
+        SDL_WaitForGPUIdle(app_state->gpu);
+    }
 
     if (app_state->render_fence) {
         SDL_ReleaseGPUFence(app_state->gpu, app_state->render_fence);
@@ -811,14 +2512,35 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result) {
         SDL_ReleaseGPUGraphicsPipeline(app_state->gpu, app_state->grid_pipeline);
     }
 
-    if (app_state->depth_texture) {
-        SDL_ReleaseGPUTexture(app_state->gpu, app_state->depth_texture);
+    if (app_state->transparent_pipeline) {
+        SDL_ReleaseGPUGraphicsPipeline(app_state->gpu, app_state->transparent_pipeline);
+    }
+
+    if (app_state->oit_composite_pipeline) {
+        SDL_ReleaseGPUGraphicsPipeline(app_state->gpu, app_state->oit_composite_pipeline);
+    }
+
+    if (app_state->oit_sampler) {
+        SDL_ReleaseGPUSampler(app_state->gpu, app_state->oit_sampler);
+    }
+
+    DestroyDrawList(&app_state->draw_list);
+    DestroyDrawList(&app_state->transparent_draw_list);
+
+    DestroyMesh(app_state->gpu_resources, &app_state->mesh);
+
+    if (app_state->gpu_resources) {
+        release_render_targets(app_state);
+        DestroyGpuResources(app_state->gpu_resources);
     }
 
-    DestroyMesh(app_state->gpu, &app_state->mesh);
+    DestroySoftRasterizer(app_state->soft_rasterizer);
+    SDL_free(app_state->soft_draws);
 
     if (app_state->window) {
-        SDL_ReleaseWindowFromGPUDevice(app_state->gpu, app_state->window);
+        if (app_state->gpu) {
+            SDL_ReleaseWindowFromGPUDevice(app_state->gpu, app_state->window);
+        }
         SDL_DestroyWindow(app_state->window);
     }
 
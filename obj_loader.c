@@ -0,0 +1,724 @@
+#include <string.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "obj_loader.h"
+
+//  Below this there isn't enough work per thread to be worth spawning one
+#define OBJ_MIN_CHUNK_SIZE (1 << 20)
+#define OBJ_MAX_CHUNKS 64
+
+#define OBJ_MAX_POLYGON_CORNERS 64
+#define OBJ_MAX_ERROR_LENGTH 128
+
+#define OBJ_ABSENT_INDEX UINT32_MAX
+
+typedef struct MappedFile {
+    const char *data;
+    size_t size;
+
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+static bool MapFile(MappedFile *mapped_file, const char *filename) {
+    SDL_zerop(mapped_file);
+
+#ifdef _WIN32
+    mapped_file->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mapped_file->file == INVALID_HANDLE_VALUE) {
+        return SDL_SetError("Failed to open \"%s\".", filename);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mapped_file->file, &size) || size.QuadPart == 0) {
+        CloseHandle(mapped_file->file);
+        return SDL_SetError("\"%s\" is empty.", filename);
+    }
+
+    mapped_file->size = (size_t) size.QuadPart;
+
+    mapped_file->mapping = CreateFileMappingA(mapped_file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapped_file->mapping) {
+        CloseHandle(mapped_file->file);
+        return SDL_SetError("Failed to map \"%s\".", filename);
+    }
+
+    mapped_file->data = MapViewOfFile(mapped_file->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mapped_file->data) {
+        CloseHandle(mapped_file->mapping);
+        CloseHandle(mapped_file->file);
+        return SDL_SetError("Failed to map \"%s\".", filename);
+    }
+#else
+    mapped_file->fd = open(filename, O_RDONLY);
+    if (mapped_file->fd < 0) {
+        return SDL_SetError("Failed to open \"%s\".", filename);
+    }
+
+    struct stat file_stat;
+    if (fstat(mapped_file->fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(mapped_file->fd);
+        return SDL_SetError("\"%s\" is empty.", filename);
+    }
+
+    mapped_file->size = (size_t) file_stat.st_size;
+
+    void *data = mmap(NULL, mapped_file->size, PROT_READ, MAP_PRIVATE, mapped_file->fd, 0);
+    if (data == MAP_FAILED) {
+        close(mapped_file->fd);
+        return SDL_SetError("Failed to map \"%s\".", filename);
+    }
+
+    madvise(data, mapped_file->size, MADV_SEQUENTIAL);
+    mapped_file->data = data;
+#endif
+
+    return true;
+}
+
+static void UnmapFile(MappedFile *mapped_file) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapped_file->data);
+    CloseHandle(mapped_file->mapping);
+    CloseHandle(mapped_file->file);
+#else
+    munmap((void *) mapped_file->data, mapped_file->size);
+    close(mapped_file->fd);
+#endif
+
+    SDL_zerop(mapped_file);
+}
+
+//  One face corner as written in the file. Negative (relative) OBJ indices can refer back into
+//  earlier chunks, so they're stored relative to the start of this chunk and flagged, and only
+//  made absolute once every chunk's counts are known.
+typedef struct ObjCorner {
+    Sint32 index[3];
+    Uint32 relative_mask;
+} ObjCorner;
+
+enum {
+    OBJ_ELEMENT_POSITION,
+    OBJ_ELEMENT_UV,
+    OBJ_ELEMENT_NORMAL,
+    OBJ_NUM_ELEMENTS,
+};
+
+static const Uint32 OBJ_ELEMENT_COMPONENTS[OBJ_NUM_ELEMENTS] = { 3, 2, 3 };
+
+typedef struct ObjChunk {
+    const char *begin;
+    const char *end;
+
+    float *elements[OBJ_NUM_ELEMENTS];
+    size_t num_elements[OBJ_NUM_ELEMENTS];
+    size_t elements_capacity[OBJ_NUM_ELEMENTS];
+
+    ObjCorner *corners;
+    size_t num_corners;
+    size_t corners_capacity;
+
+    //  SDL errors are per thread, so chunk errors are kept here and raised on the loading thread
+    bool failed;
+    char error[OBJ_MAX_ERROR_LENGTH];
+} ObjChunk;
+
+static bool Reserve(void **data, size_t *capacity, size_t needed, size_t element_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = *capacity ? *capacity : 256;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_data = SDL_realloc(*data, new_capacity * element_size);
+    if (!new_data) {
+        return false;
+    }
+
+    *data = new_data;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static const char *SkipSpaces(const char *cursor, const char *end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+        ++cursor;
+    }
+
+    return cursor;
+}
+
+//  SWAR digit parsing, checks and converts 8 ASCII digits at once in a 64 bit register.
+//  From Daniel Lemire's fast_float. Assumes a little endian load.
+static bool IsEightDigits(Uint64 chars) {
+    return !(((chars & 0xF0F0F0F0F0F0F0F0ull) | (((chars + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ^ 0x3333333333333333ull);
+}
+
+static Uint32 ParseEightDigits(Uint64 chars) {
+    const Uint64 mask = 0x000000FF000000FFull;
+    const Uint64 mul1 = 0x000F424000000064ull; // 100 + (1000000 << 32)
+    const Uint64 mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+
+    chars -= 0x3030303030303030ull;
+    chars = (chars * 10) + (chars >> 8);
+    chars = (((chars & mask) * mul1) + (((chars >> 16) & mask) * mul2)) >> 32;
+    return (Uint32) chars;
+}
+
+//  Accumulates a run of digits into mantissa, 8 at a time where possible.
+//  Returns how many digits were consumed, or -1 if there are too many to fit the fast path.
+static int ParseDigits(const char **cursor, const char *end, Uint64 *mantissa, int num_digits) {
+    const char *c = *cursor;
+    int consumed = 0;
+
+    while (end - c >= 8 && num_digits + consumed + 8 <= 19) {
+        Uint64 chars;
+        memcpy(&chars, c, sizeof(chars));
+        if (!IsEightDigits(chars)) {
+            break;
+        }
+
+        *mantissa = *mantissa * 100000000ull + ParseEightDigits(chars);
+        c += 8;
+        consumed += 8;
+    }
+
+    while (c < end && IsDigit(*c)) {
+        if (num_digits + consumed >= 19) {
+            return -1;
+        }
+
+        *mantissa = *mantissa * 10 + (Uint64) (*c - '0');
+        ++c;
+        ++consumed;
+    }
+
+    *cursor = c;
+    return consumed;
+}
+
+static bool IsTokenEnd(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//  Anything the fast path can't represent exactly (very long mantissas, large exponents, inf / nan)
+//  goes through strtod, so results match a strtod based parser bit for bit.
+static bool ParseFloatSlow(const char **cursor, const char *end, float *out) {
+    const char *token_end = *cursor;
+    while (token_end < end && !IsTokenEnd(*token_end)) {
+        ++token_end;
+    }
+
+    char token[64];
+    size_t token_length = token_end - *cursor;
+    if (token_length == 0 || token_length >= sizeof(token)) {
+        return false;
+    }
+
+    memcpy(token, *cursor, token_length);
+    token[token_length] = '\0';
+
+    char *parsed_end = NULL;
+    double value = SDL_strtod(token, &parsed_end);
+    if (parsed_end != token + token_length) {
+        return false;
+    }
+
+    *out = (float) value;
+    *cursor = token_end;
+    return true;
+}
+
+static bool ParseFloat(const char **cursor, const char *end, float *out) {
+    static const double powers_of_ten[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char *start = SkipSpaces(*cursor, end);
+    const char *c = start;
+
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+')) {
+        negative = *c == '-';
+        ++c;
+    }
+
+    Uint64 mantissa = 0;
+    int num_integer_digits = ParseDigits(&c, end, &mantissa, 0);
+    int num_fraction_digits = 0;
+
+    if (num_integer_digits >= 0 && c < end && *c == '.') {
+        ++c;
+        num_fraction_digits = ParseDigits(&c, end, &mantissa, num_integer_digits);
+    }
+
+    if (num_integer_digits < 0 || num_fraction_digits < 0 || num_integer_digits + num_fraction_digits == 0) {
+        *cursor = start;
+        return ParseFloatSlow(cursor, end, out);
+    }
+
+    int exponent = -num_fraction_digits;
+
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        ++c;
+
+        bool negative_exponent = false;
+        if (c < end && (*c == '-' || *c == '+')) {
+            negative_exponent = *c == '-';
+            ++c;
+        }
+
+        int explicit_exponent = 0;
+        while (c < end && IsDigit(*c)) {
+            if (explicit_exponent < 10000) {
+                explicit_exponent = explicit_exponent * 10 + (*c - '0');
+            }
+            ++c;
+        }
+
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+
+    if (c < end && !IsTokenEnd(*c)) {
+        return false;
+    }
+
+    //  Clinger's fast path, exact when both the mantissa and the power of ten are exact doubles
+    if (mantissa > (1ull << 53) || exponent < -22 || exponent > 22) {
+        *cursor = start;
+        return ParseFloatSlow(cursor, end, out);
+    }
+
+    double value = (double) mantissa;
+    value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+
+    *out = (float) (negative ? -value : value);
+    *cursor = c;
+    return true;
+}
+
+static bool ParseIndex(const char **cursor, const char *end, Sint64 *out) {
+    const char *c = *cursor;
+
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+')) {
+        negative = *c == '-';
+        ++c;
+    }
+
+    Sint64 value = 0;
+    const char *digits_start = c;
+    while (c < end && IsDigit(*c)) {
+        if (value < INT32_MAX) {
+            value = value * 10 + (*c - '0');
+        }
+        ++c;
+    }
+
+    if (c == digits_start || value == 0 || value > INT32_MAX) {
+        return false;
+    }
+
+    *out = negative ? -value : value;
+    *cursor = c;
+    return true;
+}
+
+static bool ChunkError(ObjChunk *chunk, const char *line, const char *message) {
+    if (!chunk->failed) {
+        chunk->failed = true;
+
+        int line_length = 0;
+        while (line + line_length < chunk->end && line[line_length] != '\n' && line[line_length] != '\r' && line_length < 48) {
+            ++line_length;
+        }
+
+        SDL_snprintf(chunk->error, sizeof(chunk->error), "%s \"%.*s\"", message, line_length, line);
+    }
+
+    return false;
+}
+
+static bool ParseElement(ObjChunk *chunk, int element, const char *cursor, const char *line_end) {
+    const char *line = cursor;
+    Uint32 num_components = OBJ_ELEMENT_COMPONENTS[element];
+
+    bool reserved = Reserve((void **) &chunk->elements[element], &chunk->elements_capacity[element], (chunk->num_elements[element] + 1) * num_components, sizeof(float));
+    if (!reserved) {
+        return ChunkError(chunk, line, "Out of memory at");
+    }
+
+    float *components = &chunk->elements[element][chunk->num_elements[element] * num_components];
+    for (Uint32 i = 0; i < num_components; ++i) {
+        components[i] = 0.0f;
+
+        const char *c = SkipSpaces(cursor, line_end);
+        if (c == line_end || *c == '\r') {
+            //  Texture coordinates may leave out v
+            if (element == OBJ_ELEMENT_UV && i > 0) {
+                break;
+            }
+
+            return ChunkError(chunk, line, "Missing component in");
+        }
+
+        if (!ParseFloat(&cursor, line_end, &components[i])) {
+            return ChunkError(chunk, line, "Invalid number in");
+        }
+    }
+
+    chunk->num_elements[element] += 1;
+    return true;
+}
+
+static bool ParseFace(ObjChunk *chunk, const char *cursor, const char *line_end) {
+    const char *line = cursor;
+
+    ObjCorner polygon[OBJ_MAX_POLYGON_CORNERS];
+    Uint32 num_polygon_corners = 0;
+
+    for (;;) {
+        cursor = SkipSpaces(cursor, line_end);
+        if (cursor == line_end || *cursor == '\r') {
+            break;
+        }
+
+        if (num_polygon_corners == OBJ_MAX_POLYGON_CORNERS) {
+            return ChunkError(chunk, line, "Too many corners in face");
+        }
+
+        ObjCorner *corner = &polygon[num_polygon_corners++];
+        corner->relative_mask = 0;
+
+        for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+            corner->index[element] = -1;
+
+            if (element > 0) {
+                if (cursor == line_end || *cursor != '/') {
+                    continue;
+                }
+
+                ++cursor;
+
+                //  "v//vn"
+                if (cursor < line_end && *cursor == '/') {
+                    continue;
+                }
+            }
+
+            Sint64 index;
+            if (!ParseIndex(&cursor, line_end, &index)) {
+                return ChunkError(chunk, line, "Invalid index in face");
+            }
+
+            if (index > 0) {
+                corner->index[element] = (Sint32) (index - 1);
+            } else {
+                corner->index[element] = (Sint32) ((Sint64) chunk->num_elements[element] + index);
+                corner->relative_mask |= 1u << element;
+            }
+        }
+
+        if (cursor < line_end && !IsTokenEnd(*cursor)) {
+            return ChunkError(chunk, line, "Invalid corner in face");
+        }
+    }
+
+    if (num_polygon_corners < 3) {
+        return ChunkError(chunk, line, "Degenerate face");
+    }
+
+    size_t num_triangle_corners = (num_polygon_corners - 2) * 3;
+    if (!Reserve((void **) &chunk->corners, &chunk->corners_capacity, chunk->num_corners + num_triangle_corners, sizeof(ObjCorner))) {
+        return ChunkError(chunk, line, "Out of memory at");
+    }
+
+    for (Uint32 i = 1; i + 1 < num_polygon_corners; ++i) {
+        chunk->corners[chunk->num_corners++] = polygon[0];
+        chunk->corners[chunk->num_corners++] = polygon[i];
+        chunk->corners[chunk->num_corners++] = polygon[i + 1];
+    }
+
+    return true;
+}
+
+static int SDLCALL ParseChunk(void *data) {
+    ObjChunk *chunk = data;
+
+    const char *cursor = chunk->begin;
+    const char *end = chunk->end;
+
+    while (cursor < end && !chunk->failed) {
+        cursor = SkipSpaces(cursor, end);
+
+        const char *line_end = memchr(cursor, '\n', end - cursor);
+        if (!line_end) {
+            line_end = end;
+        }
+
+        bool last_line = line_end == end;
+
+        if (line_end - cursor >= 2) {
+            if (cursor[0] == 'v') {
+                if (cursor[1] == ' ' || cursor[1] == '\t') {
+                    ParseElement(chunk, OBJ_ELEMENT_POSITION, cursor + 2, line_end);
+                } else if (cursor[1] == 't' && line_end - cursor >= 3 && (cursor[2] == ' ' || cursor[2] == '\t')) {
+                    ParseElement(chunk, OBJ_ELEMENT_UV, cursor + 3, line_end);
+                } else if (cursor[1] == 'n' && line_end - cursor >= 3 && (cursor[2] == ' ' || cursor[2] == '\t')) {
+                    ParseElement(chunk, OBJ_ELEMENT_NORMAL, cursor + 3, line_end);
+                }
+            } else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+                ParseFace(chunk, cursor + 2, line_end);
+            }
+        }
+
+        if (last_line) {
+            break;
+        }
+
+        cursor = line_end + 1;
+    }
+
+    return 0;
+}
+
+typedef struct ObjVertexKey {
+    Uint32 index[OBJ_NUM_ELEMENTS];
+} ObjVertexKey;
+
+static Uint32 HashVertexKey(const ObjVertexKey *key) {
+    Uint64 hash = key->index[OBJ_ELEMENT_POSITION] * 0x9E3779B97F4A7C15ull;
+    hash ^= key->index[OBJ_ELEMENT_UV] * 0xC2B2AE3D27D4EB4Full;
+    hash ^= key->index[OBJ_ELEMENT_NORMAL] * 0x165667B19E3779F9ull;
+    return (Uint32) (hash >> 32);
+}
+
+//  Resolves every corner to absolute indices and welds identical tuples, in file order, so vertex
+//  order matches first use.
+static bool BuildMesh(ObjMesh *mesh, ObjChunk *chunks, int num_chunks) {
+    size_t num_elements[OBJ_NUM_ELEMENTS] = { 0 };
+    size_t num_corners = 0;
+    for (int i = 0; i < num_chunks; ++i) {
+        for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+            num_elements[element] += chunks[i].num_elements[element];
+        }
+        num_corners += chunks[i].num_corners;
+    }
+
+    if (num_corners > (1u << 30)) {
+        return SDL_SetError("Too many face corners, %" SDL_PRIu64 ".", (Uint64) num_corners);
+    }
+
+    float *elements[OBJ_NUM_ELEMENTS] = { NULL };
+    for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+        elements[element] = SDL_malloc(SDL_max(num_elements[element], 1) * OBJ_ELEMENT_COMPONENTS[element] * sizeof(float));
+    }
+
+    Uint32 num_slots = 1;
+    while (num_slots < num_corners * 2) {
+        num_slots *= 2;
+    }
+
+    Uint32 *slots = SDL_calloc(num_slots, sizeof(Uint32));
+    ObjVertexKey *keys = SDL_malloc(SDL_max(num_corners, 1) * sizeof(ObjVertexKey));
+    mesh->vertices = SDL_malloc(SDL_max(num_corners, 1) * sizeof(ObjVertex));
+    mesh->indices = SDL_malloc(SDL_max(num_corners, 1) * sizeof(Uint32));
+
+    bool built = elements[OBJ_ELEMENT_POSITION] && elements[OBJ_ELEMENT_UV] && elements[OBJ_ELEMENT_NORMAL] && slots && keys && mesh->vertices && mesh->indices;
+    if (!built) {
+        SDL_SetError("Out of memory welding %" SDL_PRIu64 " face corners.", (Uint64) num_corners);
+    }
+
+    size_t base[OBJ_NUM_ELEMENTS] = { 0 };
+    for (int i = 0; built && i < num_chunks; ++i) {
+        const ObjChunk *chunk = &chunks[i];
+
+        for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+            Uint32 num_components = OBJ_ELEMENT_COMPONENTS[element];
+            if (chunk->num_elements[element]) {
+                memcpy(&elements[element][base[element] * num_components], chunk->elements[element], chunk->num_elements[element] * num_components * sizeof(float));
+            }
+        }
+
+        for (size_t corner_index = 0; built && corner_index < chunk->num_corners; ++corner_index) {
+            const ObjCorner *corner = &chunk->corners[corner_index];
+
+            ObjVertexKey key;
+            for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+                Sint64 index = corner->index[element];
+
+                if (corner->relative_mask & (1u << element)) {
+                    index += base[element];
+                } else if (index < 0) {
+                    key.index[element] = OBJ_ABSENT_INDEX;
+                    continue;
+                }
+
+                if (index < 0 || index >= (Sint64) num_elements[element]) {
+                    built = SDL_SetError("Face index %" SDL_PRIs64 " out of range.", index + 1);
+                    break;
+                }
+
+                key.index[element] = (Uint32) index;
+            }
+
+            if (!built) {
+                break;
+            }
+
+            if (key.index[OBJ_ELEMENT_POSITION] == OBJ_ABSENT_INDEX) {
+                built = SDL_SetError("Face corner without a position.");
+                break;
+            }
+
+            Uint32 slot = HashVertexKey(&key) & (num_slots - 1);
+            while (slots[slot] && memcmp(&keys[slots[slot] - 1], &key, sizeof(key)) != 0) {
+                slot = (slot + 1) & (num_slots - 1);
+            }
+
+            if (!slots[slot]) {
+                Uint32 vertex_index = mesh->num_vertices++;
+                slots[slot] = vertex_index + 1;
+                keys[vertex_index] = key;
+
+                ObjVertex *vertex = &mesh->vertices[vertex_index];
+                SDL_zerop(vertex);
+                memcpy(vertex->position, &elements[OBJ_ELEMENT_POSITION][key.index[OBJ_ELEMENT_POSITION] * 3], sizeof(vertex->position));
+
+                if (key.index[OBJ_ELEMENT_UV] != OBJ_ABSENT_INDEX) {
+                    memcpy(vertex->uv, &elements[OBJ_ELEMENT_UV][key.index[OBJ_ELEMENT_UV] * 2], sizeof(vertex->uv));
+                }
+
+                if (key.index[OBJ_ELEMENT_NORMAL] != OBJ_ABSENT_INDEX) {
+                    memcpy(vertex->normal, &elements[OBJ_ELEMENT_NORMAL][key.index[OBJ_ELEMENT_NORMAL] * 3], sizeof(vertex->normal));
+                }
+            }
+
+            mesh->indices[mesh->num_indices++] = slots[slot] - 1;
+        }
+
+        for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+            base[element] += chunk->num_elements[element];
+        }
+    }
+
+    for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+        SDL_free(elements[element]);
+    }
+    SDL_free(slots);
+    SDL_free(keys);
+
+    if (built && mesh->num_vertices < num_corners) {
+        ObjVertex *vertices = SDL_realloc(mesh->vertices, SDL_max(mesh->num_vertices, 1) * sizeof(ObjVertex));
+        if (vertices) {
+            mesh->vertices = vertices;
+        }
+    }
+
+    return built;
+}
+
+bool LoadObj(ObjMesh *mesh, const char *filename) {
+    SDL_zerop(mesh);
+
+    MappedFile file;
+    if (!MapFile(&file, filename)) {
+        return false;
+    }
+
+    int num_chunks = (int) SDL_min(file.size / OBJ_MIN_CHUNK_SIZE + 1, (size_t) OBJ_MAX_CHUNKS);
+    num_chunks = SDL_min(num_chunks, SDL_max(SDL_GetNumLogicalCPUCores(), 1));
+
+    ObjChunk chunks[OBJ_MAX_CHUNKS];
+    SDL_Thread *threads[OBJ_MAX_CHUNKS] = { NULL };
+    SDL_memset(chunks, 0, sizeof(ObjChunk) * num_chunks);
+
+    //  Split evenly, then push each split forward to just past the next newline
+    const char *file_end = file.data + file.size;
+    const char *chunk_begin = file.data;
+    for (int i = 0; i < num_chunks; ++i) {
+        const char *chunk_end = file_end;
+
+        if (i + 1 < num_chunks) {
+            chunk_end = file.data + file.size / num_chunks * (i + 1);
+            if (chunk_end < chunk_begin) {
+                chunk_end = chunk_begin;
+            }
+
+            const char *newline = memchr(chunk_end, '\n', file_end - chunk_end);
+            chunk_end = newline ? newline + 1 : file_end;
+        }
+
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+
+    //  Chunk 0 is parsed on this thread
+    for (int i = 1; i < num_chunks; ++i) {
+        threads[i] = SDL_CreateThread(ParseChunk, "OBJ Parser", &chunks[i]);
+    }
+
+    ParseChunk(&chunks[0]);
+
+    for (int i = 1; i < num_chunks; ++i) {
+        if (threads[i]) {
+            SDL_WaitThread(threads[i], NULL);
+        } else {
+            ParseChunk(&chunks[i]);
+        }
+    }
+
+    bool loaded = true;
+    for (int i = 0; loaded && i < num_chunks; ++i) {
+        if (chunks[i].failed) {
+            loaded = SDL_SetError("Failed to parse \"%s\". %s", filename, chunks[i].error);
+        }
+    }
+
+    if (loaded) {
+        loaded = BuildMesh(mesh, chunks, num_chunks);
+    }
+
+    for (int i = 0; i < num_chunks; ++i) {
+        for (int element = 0; element < OBJ_NUM_ELEMENTS; ++element) {
+            SDL_free(chunks[i].elements[element]);
+        }
+        SDL_free(chunks[i].corners);
+    }
+
+    UnmapFile(&file);
+
+    if (!loaded) {
+        DestroyObjMesh(mesh);
+    }
+
+    return loaded;
+}
+
+void DestroyObjMesh(ObjMesh *mesh) {
+    SDL_free(mesh->vertices);
+    SDL_free(mesh->indices);
+    SDL_zerop(mesh);
+}
@@ -0,0 +1,30 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include "SDL3/SDL.h"
+
+//  Wavefront OBJ importer for large models. The file is memory mapped, split into chunks at line
+//  boundaries and the chunks are parsed in parallel. Position / uv / normal tuples are then welded
+//  into unique vertices, in the order they're first referenced. Polygons are fan triangulated.
+//
+//  Only geometry is read, groups, objects and materials are ignored.
+
+typedef struct ObjVertex {
+    float position[3];
+    float uv[2];
+    float normal[3];
+} ObjVertex;
+
+typedef struct ObjMesh {
+    ObjVertex *vertices;
+    Uint32 num_vertices;
+
+    Uint32 *indices;
+    Uint32 num_indices;
+} ObjMesh;
+
+//  On failure returns false, and the reason is available from SDL_GetError
+bool LoadObj(ObjMesh *mesh, const char *filename);
+void DestroyObjMesh(ObjMesh *mesh);
+
+#endif
@@ -0,0 +1,22 @@
+#version 460
+
+// Resolves transparent.frag's targets over the opaque scene, blended SRC_ALPHA, ONE_MINUS_SRC_ALPHA
+
+layout (location = 0) out vec4 out_color;
+
+layout (set = 2, binding = 0) uniform sampler2D accumulation_texture;
+layout (set = 2, binding = 1) uniform sampler2D revealage_texture;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    float revealage = texelFetch(revealage_texture, pixel, 0).r;
+    if (revealage >= 1.0) {
+        discard;
+    }
+
+    vec4 accumulation = texelFetch(accumulation_texture, pixel, 0);
+    vec3 average_color = accumulation.rgb / clamp(accumulation.a, 1e-4, 5e4);
+
+    out_color = vec4(average_color, 1.0 - revealage);
+}
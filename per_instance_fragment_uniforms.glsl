@@ -0,0 +1,3 @@
+layout (set = 3, binding = 2) uniform PerInstanceFragmentUniformBlock {
+    vec4 color;
+} per_instance_fragment_uniforms;
@@ -0,0 +1,321 @@
+//  Build tool, packs compiled SPIR-V shaders into a single bundle for the engine to load.
+//
+//  usage: shader_bundle <output bundle> <shader.spv>...
+//
+//  Each shader is named after its file, minus the ".spv" extension, e.g. "grid.vert.spv" -> "grid.vert".
+//  The stage and resource counts the engine needs to create the shader are reflected from the SPIR-V.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shader_bundle.h"
+
+#define SPIRV_MAGIC 0x07230203
+#define SPIRV_HEADER_WORDS 5
+
+enum {
+    SPIRV_OP_ENTRY_POINT        = 15,
+    SPIRV_OP_TYPE_IMAGE         = 25,
+    SPIRV_OP_TYPE_SAMPLER       = 26,
+    SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+    SPIRV_OP_TYPE_ARRAY         = 28,
+    SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+    SPIRV_OP_TYPE_STRUCT        = 30,
+    SPIRV_OP_TYPE_POINTER       = 32,
+    SPIRV_OP_VARIABLE           = 59,
+    SPIRV_OP_DECORATE           = 71,
+};
+
+enum {
+    SPIRV_EXECUTION_MODEL_VERTEX   = 0,
+    SPIRV_EXECUTION_MODEL_FRAGMENT = 4,
+};
+
+enum {
+    SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT = 0,
+    SPIRV_STORAGE_CLASS_UNIFORM          = 2,
+    SPIRV_STORAGE_CLASS_STORAGE_BUFFER   = 12,
+};
+
+enum {
+    SPIRV_DECORATION_BLOCK        = 2,
+    SPIRV_DECORATION_BUFFER_BLOCK = 3,
+    SPIRV_DECORATION_BINDING      = 33,
+};
+
+typedef struct SpirvId {
+    uint32_t opcode;
+    uint32_t type;          //  pointee / element type for pointers and arrays
+    uint32_t storage_class;
+    uint32_t image_sampled; //  1 = sampled texture, 2 = storage texture
+    uint32_t binding;
+    bool is_buffer_block;
+} SpirvId;
+
+typedef struct Shader {
+    char name[SHADER_BUNDLE_MAX_NAME_LENGTH];
+    uint32_t *code;
+    uint32_t code_size;
+    ShaderBundleEntry entry;
+} Shader;
+
+uint32_t *read_file(const char *filename, uint32_t *size) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open \"%s\".\n", filename);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint32_t *data = malloc(file_size);
+    size_t num_bytes_read = data ? fread(data, 1, file_size, file) : 0;
+    fclose(file);
+
+    if (num_bytes_read != (size_t) file_size) {
+        fprintf(stderr, "Failed to read \"%s\".\n", filename);
+        free(data);
+        return NULL;
+    }
+
+    *size = (uint32_t) file_size;
+    return data;
+}
+
+//  SDL_GPU binds uniform buffers by slot, so their count has to cover the highest binding even if
+//  some are unused. Samplers, storage textures and storage buffers share a descriptor set, so those
+//  are just counted.
+bool reflect_shader(Shader *shader) {
+    const uint32_t *words = shader->code;
+    uint32_t num_words = shader->code_size / sizeof(uint32_t);
+
+    if (num_words < SPIRV_HEADER_WORDS || words[0] != SPIRV_MAGIC) {
+        fprintf(stderr, "\"%s\" is not SPIR-V.\n", shader->name);
+        return false;
+    }
+
+    uint32_t id_bound = words[3];
+    SpirvId *ids = calloc(id_bound, sizeof(SpirvId));
+    if (!ids) {
+        fprintf(stderr, "Out of memory reflecting \"%s\".\n", shader->name);
+        return false;
+    }
+
+    bool found_entry_point = false;
+    ShaderBundleEntry *entry = &shader->entry;
+
+    for (uint32_t i = SPIRV_HEADER_WORDS; i < num_words;) {
+        uint32_t word_count = words[i] >> 16;
+        uint32_t opcode = words[i] & 0xFFFF;
+        const uint32_t *operands = &words[i + 1];
+
+        if (word_count == 0 || i + word_count > num_words) {
+            fprintf(stderr, "Malformed SPIR-V in \"%s\".\n", shader->name);
+            free(ids);
+            return false;
+        }
+
+        switch (opcode) {
+            case SPIRV_OP_ENTRY_POINT: {
+                if (operands[0] == SPIRV_EXECUTION_MODEL_VERTEX) {
+                    entry->stage = SHADER_BUNDLE_STAGE_VERTEX;
+                } else if (operands[0] == SPIRV_EXECUTION_MODEL_FRAGMENT) {
+                    entry->stage = SHADER_BUNDLE_STAGE_FRAGMENT;
+                } else {
+                    fprintf(stderr, "Unsupported execution model %u in \"%s\".\n", operands[0], shader->name);
+                    free(ids);
+                    return false;
+                }
+
+                found_entry_point = true;
+            } break;
+
+            case SPIRV_OP_DECORATE: {
+                if (operands[0] < id_bound) {
+                    SpirvId *target = &ids[operands[0]];
+                    if (operands[1] == SPIRV_DECORATION_BINDING) {
+                        target->binding = operands[2];
+                    } else if (operands[1] == SPIRV_DECORATION_BUFFER_BLOCK) {
+                        target->is_buffer_block = true;
+                    }
+                }
+            } break;
+
+            case SPIRV_OP_TYPE_IMAGE: {
+                ids[operands[0]].opcode = opcode;
+                ids[operands[0]].image_sampled = operands[6];
+            } break;
+
+            case SPIRV_OP_TYPE_SAMPLER:
+            case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+            case SPIRV_OP_TYPE_STRUCT: {
+                ids[operands[0]].opcode = opcode;
+            } break;
+
+            case SPIRV_OP_TYPE_ARRAY:
+            case SPIRV_OP_TYPE_RUNTIME_ARRAY: {
+                ids[operands[0]].opcode = opcode;
+                ids[operands[0]].type = operands[1];
+            } break;
+
+            case SPIRV_OP_TYPE_POINTER: {
+                ids[operands[0]].opcode = opcode;
+                ids[operands[0]].storage_class = operands[1];
+                ids[operands[0]].type = operands[2];
+            } break;
+
+            case SPIRV_OP_VARIABLE: {
+                ids[operands[1]].opcode = opcode;
+                ids[operands[1]].type = operands[0];
+                ids[operands[1]].storage_class = operands[2];
+            } break;
+        }
+
+        i += word_count;
+    }
+
+    //  Decorations can come before or after the types they decorate, so classify once everything is known
+    for (uint32_t id = 0; id < id_bound; ++id) {
+        const SpirvId *variable = &ids[id];
+        if (variable->opcode != SPIRV_OP_VARIABLE) {
+            continue;
+        }
+
+        const SpirvId *type = &ids[ids[variable->type].type];
+        while (type->opcode == SPIRV_OP_TYPE_ARRAY || type->opcode == SPIRV_OP_TYPE_RUNTIME_ARRAY) {
+            type = &ids[type->type];
+        }
+
+        switch (variable->storage_class) {
+            case SPIRV_STORAGE_CLASS_UNIFORM: {
+                if (type->is_buffer_block) {
+                    entry->num_storage_buffers += 1;
+                } else if (variable->binding + 1 > entry->num_uniform_buffers) {
+                    entry->num_uniform_buffers = variable->binding + 1;
+                }
+            } break;
+
+            case SPIRV_STORAGE_CLASS_STORAGE_BUFFER: {
+                entry->num_storage_buffers += 1;
+            } break;
+
+            case SPIRV_STORAGE_CLASS_UNIFORM_CONSTANT: {
+                if (type->opcode == SPIRV_OP_TYPE_SAMPLED_IMAGE) {
+                    entry->num_samplers += 1;
+                } else if (type->opcode == SPIRV_OP_TYPE_IMAGE && type->image_sampled == 2) {
+                    entry->num_storage_textures += 1;
+                }
+            } break;
+        }
+    }
+
+    free(ids);
+
+    if (!found_entry_point) {
+        fprintf(stderr, "No entry point in \"%s\".\n", shader->name);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <output bundle> <shader.spv>...\n", argv[0]);
+        return 1;
+    }
+
+    const char *output_filename = argv[1];
+    uint32_t num_shaders = argc - 2;
+
+    Shader *shaders = calloc(num_shaders, sizeof(Shader));
+    if (!shaders) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    uint32_t code_offset = sizeof(ShaderBundleHeader) + sizeof(ShaderBundleEntry) * num_shaders;
+
+    for (uint32_t i = 0; i < num_shaders; ++i) {
+        const char *filename = argv[i + 2];
+        Shader *shader = &shaders[i];
+
+        const char *basename = filename;
+        for (const char *c = filename; *c; ++c) {
+            if (*c == '/' || *c == '\\') {
+                basename = c + 1;
+            }
+        }
+
+        size_t name_length = strlen(basename);
+        if (name_length > 4 && strcmp(basename + name_length - 4, ".spv") == 0) {
+            name_length -= 4;
+        }
+
+        if (name_length >= SHADER_BUNDLE_MAX_NAME_LENGTH) {
+            fprintf(stderr, "Shader name \"%s\" is too long.\n", basename);
+            return 1;
+        }
+
+        memcpy(shader->name, basename, name_length);
+
+        shader->code = read_file(filename, &shader->code_size);
+        if (!shader->code || !reflect_shader(shader)) {
+            return 1;
+        }
+
+        memcpy(shader->entry.name, shader->name, sizeof(shader->name));
+        shader->entry.code_offset = code_offset;
+        shader->entry.code_size = shader->code_size;
+        code_offset += shader->code_size;
+
+        printf("%-32s %-8s samplers %u, storage textures %u, storage buffers %u, uniform buffers %u\n",
+            shader->name,
+            shader->entry.stage == SHADER_BUNDLE_STAGE_VERTEX ? "vertex" : "fragment",
+            shader->entry.num_samplers,
+            shader->entry.num_storage_textures,
+            shader->entry.num_storage_buffers,
+            shader->entry.num_uniform_buffers);
+    }
+
+    FILE *output = fopen(output_filename, "wb");
+    if (!output) {
+        fprintf(stderr, "Failed to open \"%s\" for writing.\n", output_filename);
+        return 1;
+    }
+
+    ShaderBundleHeader header = {
+        .magic       = SHADER_BUNDLE_MAGIC,
+        .version     = SHADER_BUNDLE_VERSION,
+        .num_shaders = num_shaders,
+    };
+
+    bool written = fwrite(&header, sizeof(header), 1, output) == 1;
+
+    for (uint32_t i = 0; written && i < num_shaders; ++i) {
+        written = fwrite(&shaders[i].entry, sizeof(ShaderBundleEntry), 1, output) == 1;
+    }
+
+    for (uint32_t i = 0; written && i < num_shaders; ++i) {
+        written = fwrite(shaders[i].code, shaders[i].code_size, 1, output) == 1;
+    }
+
+    fclose(output);
+
+    if (!written) {
+        fprintf(stderr, "Failed to write \"%s\".\n", output_filename);
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < num_shaders; ++i) {
+        free(shaders[i].code);
+    }
+    free(shaders);
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef SHADER_BUNDLE_H
+#define SHADER_BUNDLE_H
+
+#include <stdint.h>
+
+//  Every compiled shader permutation, packed into one file so startup only has to read it once.
+//
+//  Layout:
+//      ShaderBundleHeader
+//      ShaderBundleEntry[num_shaders]
+//      SPIR-V code, each entry pointing into it with code_offset / code_size (offsets from the start of the file)
+//
+//  Resource counts are reflected from the SPIR-V by the shader_bundle tool when the bundle is built.
+
+#define SHADER_BUNDLE_MAGIC   0x4248534A // "JSHB"
+#define SHADER_BUNDLE_VERSION 1
+
+#define SHADER_BUNDLE_MAX_NAME_LENGTH 64
+
+typedef enum ShaderBundleStage {
+    SHADER_BUNDLE_STAGE_VERTEX   = 0,
+    SHADER_BUNDLE_STAGE_FRAGMENT = 1,
+} ShaderBundleStage;
+
+typedef struct ShaderBundleHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_shaders;
+    uint32_t reserved;
+} ShaderBundleHeader;
+
+typedef struct ShaderBundleEntry {
+    char name[SHADER_BUNDLE_MAX_NAME_LENGTH];
+
+    uint32_t stage;
+    uint32_t num_samplers;
+    uint32_t num_storage_textures;
+    uint32_t num_storage_buffers;
+    uint32_t num_uniform_buffers;
+
+    uint32_t code_offset;
+    uint32_t code_size;
+    uint32_t reserved;
+} ShaderBundleEntry;
+
+#endif
@@ -0,0 +1,1116 @@
+#include <string.h>
+
+#if !(defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+    #error "The software rasterizer requires SSE2"
+#endif
+
+#include <emmintrin.h>
+
+#include "soft_rasterizer.h"
+
+#define SOFT_TILE_SIZE 64
+#define SOFT_TILE_PIXELS (SOFT_TILE_SIZE * SOFT_TILE_SIZE)
+#define SOFT_MAX_THREADS 32
+
+//  Clip space guard band, in multiples of w. Triangles are only clipped against x / y once they
+//  reach past it, which keeps screen coordinates small enough for float edge functions.
+#define SOFT_GUARD_BAND 4.0f
+
+//  Vertices are snapped to 1/256th of a pixel, like the GPU's sub pixel precision
+#define SOFT_SUBPIXEL_SCALE 256.0f
+
+#define SOFT_MAX_CLIPPED_VERTICES 9
+
+typedef struct SoftVertex {
+    HMM_Vec4 clip_position;
+    HMM_Vec3 world_normal;
+} SoftVertex;
+
+//  Edge i is opposite vertex i. Edges are scaled so they're positive inside, and evaluate to twice
+//  the triangle's area at the opposite vertex, so e_i * inv_area is vertex i's barycentric weight.
+typedef struct SoftTriangle {
+    float edge_a[3];
+    float edge_b[3];
+    float edge_c[3];
+    Uint32 top_left_mask;
+    float inv_area;
+
+    float depth[3];
+    float inv_w[3];
+    float normal_over_w[3][3];
+
+    int min_x, min_y, max_x, max_y;
+
+    //  Indexes opaque draws, then transparent ones
+    Uint32 draw_index;
+} SoftTriangle;
+
+typedef struct SoftBin {
+    Uint32 *triangles;
+    Uint32 num_triangles;
+    Uint32 capacity;
+} SoftBin;
+
+typedef struct SoftWorker {
+    SoftRasterizer *rasterizer;
+    int index;
+
+    SDL_Thread    *thread;
+    SDL_Semaphore *start;
+
+    //  Triangles this worker set up, and for each tile, which of them touch it, in submission order
+    SoftTriangle *triangles;
+    Uint32 num_triangles;
+    Uint32 triangles_capacity;
+
+    SoftBin *bins;
+
+    //  Weighted blended OIT targets for the tile being rasterized: accumulation r, g, b, a, then
+    //  revealage, each SOFT_TILE_PIXELS floats
+    float *oit_targets;
+} SoftWorker;
+
+typedef void (*SoftJob)(SoftRasterizer *rasterizer, SoftWorker *worker);
+
+struct SoftRasterizer {
+    Uint32 width;
+    Uint32 height;
+    Uint32 num_tiles_x;
+    Uint32 num_tiles_y;
+
+    //  Padded out to whole tiles, so SIMD loads and stores never need bounds checks
+    Uint32 pitch;
+    Uint32 *color;
+    Uint16 *depth;
+
+    int num_threads;
+    SoftWorker workers[SOFT_MAX_THREADS];
+
+    SoftJob job;
+    SDL_Semaphore *job_finished;
+    SDL_AtomicInt next_tile;
+    SDL_AtomicInt failed;
+    SDL_AtomicInt quit;
+
+    //  Current frame, draw indices cover the opaque draws, then the transparent ones
+    const SoftFrame *frame;
+    Uint32 num_draws;
+    HMM_Mat4 *draw_mvp_matrices;
+    Uint32 draw_mvp_matrices_capacity;
+    Uint32 *draw_first_vertex;
+    Uint32 draw_first_vertex_capacity;
+    Uint32 *draw_first_triangle;
+    Uint32 draw_first_triangle_capacity;
+    Uint32 num_vertices;
+    Uint32 num_triangles;
+
+    SoftVertex *vertices;
+    Uint32 vertices_capacity;
+
+    //  The grid plane is intersected with each pixel's ray, from its near to its far point. Both are
+    //  affine in NDC: point = center + x * x_axis + y * y_axis
+    HMM_Vec3 grid_near_center, grid_near_x, grid_near_y;
+    HMM_Vec3 grid_far_center, grid_far_x, grid_far_y;
+};
+
+static bool Reserve(void **data, Uint32 *capacity, Uint32 needed, size_t element_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+
+    Uint32 new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void *new_data = SDL_realloc(*data, new_capacity * element_size);
+    if (!new_data) {
+        return false;
+    }
+
+    *data = new_data;
+    *capacity = new_capacity;
+    return true;
+}
+
+static const SoftMeshDraw *GetDraw(const SoftFrame *frame, Uint32 draw_index) {
+    if (draw_index < frame->num_draws) {
+        return &frame->draws[draw_index];
+    }
+
+    return &frame->transparent_draws[draw_index - frame->num_draws];
+}
+
+//  Runs job on every worker, worker 0 being the calling thread, and waits for all of them
+static void RunJob(SoftRasterizer *rasterizer, SoftJob job) {
+    rasterizer->job = job;
+
+    for (int i = 1; i < rasterizer->num_threads; ++i) {
+        SDL_SignalSemaphore(rasterizer->workers[i].start);
+    }
+
+    job(rasterizer, &rasterizer->workers[0]);
+
+    for (int i = 1; i < rasterizer->num_threads; ++i) {
+        SDL_WaitSemaphore(rasterizer->job_finished);
+    }
+}
+
+static int SDLCALL SoftWorkerThread(void *data) {
+    SoftWorker *worker = data;
+    SoftRasterizer *rasterizer = worker->rasterizer;
+
+    for (;;) {
+        SDL_WaitSemaphore(worker->start);
+        if (SDL_GetAtomicInt(&rasterizer->quit)) {
+            break;
+        }
+
+        rasterizer->job(rasterizer, worker);
+        SDL_SignalSemaphore(rasterizer->job_finished);
+    }
+
+    return 0;
+}
+
+//  Contiguous share of count items for this worker, so per worker results stay in submission order
+static void WorkerRange(const SoftRasterizer *rasterizer, const SoftWorker *worker, Uint32 count, Uint32 *begin, Uint32 *end) {
+    *begin = (Uint32) ((Uint64) count * worker->index / rasterizer->num_threads);
+    *end   = (Uint32) ((Uint64) count * (worker->index + 1) / rasterizer->num_threads);
+}
+
+static void TransformVerticesJob(SoftRasterizer *rasterizer, SoftWorker *worker) {
+    const SoftFrame *frame = rasterizer->frame;
+
+    Uint32 begin, end;
+    WorkerRange(rasterizer, worker, rasterizer->num_vertices, &begin, &end);
+
+    Uint32 draw_index = 0;
+    while (draw_index + 1 < rasterizer->num_draws && rasterizer->draw_first_vertex[draw_index + 1] <= begin) {
+        ++draw_index;
+    }
+
+    for (Uint32 i = begin; i < end; ++i) {
+        while (rasterizer->draw_first_vertex[draw_index + 1] <= i) {
+            ++draw_index;
+        }
+
+        const SoftMeshDraw *draw = GetDraw(frame, draw_index);
+        const ObjVertex *vertex = &draw->vertices[i - rasterizer->draw_first_vertex[draw_index]];
+
+        HMM_Vec4 position = HMM_V4(vertex->position[0], vertex->position[1], vertex->position[2], 1);
+        HMM_Vec4 normal = HMM_V4(vertex->normal[0], vertex->normal[1], vertex->normal[2], 1);
+
+        rasterizer->vertices[i].clip_position = HMM_MulM4V4(rasterizer->draw_mvp_matrices[draw_index], position);
+        rasterizer->vertices[i].world_normal = HMM_MulM4V4(draw->model_rotation_matrix, normal).XYZ;
+    }
+}
+
+typedef struct SoftClipVertex {
+    float values[7]; // clip x, y, z, w, normal x, y, z
+} SoftClipVertex;
+
+static float ClipDistance(const SoftClipVertex *vertex, int plane) {
+    const float *v = vertex->values;
+    switch (plane) {
+        case 0:  return v[2];                               // z >= 0
+        case 1:  return v[3] - v[2];                        // z <= w
+        case 2:  return SOFT_GUARD_BAND * v[3] - v[0];
+        case 3:  return SOFT_GUARD_BAND * v[3] + v[0];
+        case 4:  return SOFT_GUARD_BAND * v[3] - v[1];
+        default: return SOFT_GUARD_BAND * v[3] + v[1];
+    }
+}
+
+static Uint32 OutCode(const SoftClipVertex *vertex) {
+    Uint32 code = 0;
+    for (int plane = 0; plane < 6; ++plane) {
+        if (ClipDistance(vertex, plane) < 0) {
+            code |= 1u << plane;
+        }
+    }
+
+    return code;
+}
+
+static int ClipPolygon(const SoftClipVertex *input, int num_input, SoftClipVertex *output, int plane) {
+    int num_output = 0;
+
+    for (int i = 0; i < num_input; ++i) {
+        const SoftClipVertex *current = &input[i];
+        const SoftClipVertex *next = &input[(i + 1) % num_input];
+
+        float current_distance = ClipDistance(current, plane);
+        float next_distance = ClipDistance(next, plane);
+
+        if (current_distance >= 0) {
+            output[num_output++] = *current;
+        }
+
+        if ((current_distance >= 0) != (next_distance >= 0)) {
+            float t = current_distance / (current_distance - next_distance);
+
+            SoftClipVertex *clipped = &output[num_output++];
+            for (int value = 0; value < 7; ++value) {
+                clipped->values[value] = current->values[value] + (next->values[value] - current->values[value]) * t;
+            }
+        }
+    }
+
+    return num_output;
+}
+
+typedef struct SoftScreenVertex {
+    float x, y;
+    float depth;
+    float inv_w;
+    float normal_over_w[3];
+} SoftScreenVertex;
+
+//  Shared edges are always computed from their endpoints in the same order, so neighbouring
+//  triangles get exactly negated coefficients and the top-left rule can't leave cracks or overlaps
+static void SetupEdge(SoftTriangle *triangle, int edge, const SoftScreenVertex *p, const SoftScreenVertex *q, float sign) {
+    if (q->y < p->y || (q->y == p->y && q->x < p->x)) {
+        const SoftScreenVertex *swap = p;
+        p = q;
+        q = swap;
+        sign = -sign;
+    }
+
+    float a = p->y - q->y;
+    float b = q->x - p->x;
+    float c = (q->y - p->y) * p->x - (q->x - p->x) * p->y;
+
+    triangle->edge_a[edge] = a * sign;
+    triangle->edge_b[edge] = b * sign;
+    triangle->edge_c[edge] = c * sign;
+
+    bool top_left = triangle->edge_a[edge] > 0 || (triangle->edge_a[edge] == 0 && triangle->edge_b[edge] > 0);
+    if (top_left) {
+        triangle->top_left_mask |= 1u << edge;
+    }
+}
+
+static bool BinTriangle(SoftRasterizer *rasterizer, SoftWorker *worker, const SoftClipVertex *clip_vertices[3], Uint32 draw_index) {
+    SoftScreenVertex screen[3];
+    for (int i = 0; i < 3; ++i) {
+        const float *v = clip_vertices[i]->values;
+        float inv_w = 1.0f / v[3];
+
+        float x = (v[0] * inv_w * 0.5f + 0.5f) * rasterizer->width;
+        float y = (0.5f - v[1] * inv_w * 0.5f) * rasterizer->height;
+
+        screen[i].x = SDL_floorf(x * SOFT_SUBPIXEL_SCALE + 0.5f) / SOFT_SUBPIXEL_SCALE;
+        screen[i].y = SDL_floorf(y * SOFT_SUBPIXEL_SCALE + 0.5f) / SOFT_SUBPIXEL_SCALE;
+        screen[i].depth = v[2] * inv_w;
+        screen[i].inv_w = inv_w;
+        screen[i].normal_over_w[0] = v[4] * inv_w;
+        screen[i].normal_over_w[1] = v[5] * inv_w;
+        screen[i].normal_over_w[2] = v[6] * inv_w;
+    }
+
+    //  Screen space is y down, so counter clockwise front faces have negative area
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+    if (area >= 0) {
+        return true;
+    }
+
+    float min_x = SDL_min(screen[0].x, SDL_min(screen[1].x, screen[2].x));
+    float min_y = SDL_min(screen[0].y, SDL_min(screen[1].y, screen[2].y));
+    float max_x = SDL_max(screen[0].x, SDL_max(screen[1].x, screen[2].x));
+    float max_y = SDL_max(screen[0].y, SDL_max(screen[1].y, screen[2].y));
+
+    //  Pixels whose centers fall inside the bounds
+    int pixel_min_x = SDL_max((int) SDL_ceilf(min_x - 0.5f), 0);
+    int pixel_min_y = SDL_max((int) SDL_ceilf(min_y - 0.5f), 0);
+    int pixel_max_x = SDL_min((int) SDL_floorf(max_x - 0.5f), (int) rasterizer->width - 1);
+    int pixel_max_y = SDL_min((int) SDL_floorf(max_y - 0.5f), (int) rasterizer->height - 1);
+
+    if (pixel_min_x > pixel_max_x || pixel_min_y > pixel_max_y) {
+        return true;
+    }
+
+    if (!Reserve((void **) &worker->triangles, &worker->triangles_capacity, worker->num_triangles + 1, sizeof(SoftTriangle))) {
+        return false;
+    }
+
+    Uint32 triangle_index = worker->num_triangles++;
+    SoftTriangle *triangle = &worker->triangles[triangle_index];
+    SDL_zerop(triangle);
+
+    SetupEdge(triangle, 0, &screen[1], &screen[2], -1.0f);
+    SetupEdge(triangle, 1, &screen[2], &screen[0], -1.0f);
+    SetupEdge(triangle, 2, &screen[0], &screen[1], -1.0f);
+    triangle->inv_area = 1.0f / -area;
+
+    for (int i = 0; i < 3; ++i) {
+        triangle->depth[i] = screen[i].depth;
+        triangle->inv_w[i] = screen[i].inv_w;
+        triangle->normal_over_w[i][0] = screen[i].normal_over_w[0];
+        triangle->normal_over_w[i][1] = screen[i].normal_over_w[1];
+        triangle->normal_over_w[i][2] = screen[i].normal_over_w[2];
+    }
+
+    triangle->min_x = pixel_min_x;
+    triangle->min_y = pixel_min_y;
+    triangle->max_x = pixel_max_x;
+    triangle->max_y = pixel_max_y;
+    triangle->draw_index = draw_index;
+
+    for (int tile_y = pixel_min_y / SOFT_TILE_SIZE; tile_y <= pixel_max_y / SOFT_TILE_SIZE; ++tile_y) {
+        for (int tile_x = pixel_min_x / SOFT_TILE_SIZE; tile_x <= pixel_max_x / SOFT_TILE_SIZE; ++tile_x) {
+            SoftBin *bin = &worker->bins[tile_y * rasterizer->num_tiles_x + tile_x];
+            if (!Reserve((void **) &bin->triangles, &bin->capacity, bin->num_triangles + 1, sizeof(Uint32))) {
+                return false;
+            }
+
+            bin->triangles[bin->num_triangles++] = triangle_index;
+        }
+    }
+
+    return true;
+}
+
+static void BinTrianglesJob(SoftRasterizer *rasterizer, SoftWorker *worker) {
+    const SoftFrame *frame = rasterizer->frame;
+
+    worker->num_triangles = 0;
+    for (Uint32 i = 0; i < rasterizer->num_tiles_x * rasterizer->num_tiles_y; ++i) {
+        worker->bins[i].num_triangles = 0;
+    }
+
+    Uint32 begin, end;
+    WorkerRange(rasterizer, worker, rasterizer->num_triangles, &begin, &end);
+
+    Uint32 draw_index = 0;
+    while (draw_index + 1 < rasterizer->num_draws && rasterizer->draw_first_triangle[draw_index + 1] <= begin) {
+        ++draw_index;
+    }
+
+    for (Uint32 i = begin; i < end; ++i) {
+        while (rasterizer->draw_first_triangle[draw_index + 1] <= i) {
+            ++draw_index;
+        }
+
+        const SoftMeshDraw *draw = GetDraw(frame, draw_index);
+        const Uint32 *indices = &draw->indices[(i - rasterizer->draw_first_triangle[draw_index]) * 3];
+        const SoftVertex *draw_vertices = &rasterizer->vertices[rasterizer->draw_first_vertex[draw_index]];
+
+        SoftClipVertex polygon[2][SOFT_MAX_CLIPPED_VERTICES];
+        Uint32 out_codes[3];
+        for (int corner = 0; corner < 3; ++corner) {
+            const SoftVertex *vertex = &draw_vertices[indices[corner]];
+            float *values = polygon[0][corner].values;
+            values[0] = vertex->clip_position.X;
+            values[1] = vertex->clip_position.Y;
+            values[2] = vertex->clip_position.Z;
+            values[3] = vertex->clip_position.W;
+            values[4] = vertex->world_normal.X;
+            values[5] = vertex->world_normal.Y;
+            values[6] = vertex->world_normal.Z;
+            out_codes[corner] = OutCode(&polygon[0][corner]);
+        }
+
+        if (out_codes[0] & out_codes[1] & out_codes[2]) {
+            continue;
+        }
+
+        int num_polygon_vertices = 3;
+        int current = 0;
+        Uint32 clip_planes = out_codes[0] | out_codes[1] | out_codes[2];
+        for (int plane = 0; clip_planes && plane < 6; ++plane) {
+            if (clip_planes & (1u << plane)) {
+                num_polygon_vertices = ClipPolygon(polygon[current], num_polygon_vertices, polygon[1 - current], plane);
+                current = 1 - current;
+            }
+        }
+
+        for (int corner = 1; corner + 1 < num_polygon_vertices; ++corner) {
+            const SoftClipVertex *triangle[3] = { &polygon[current][0], &polygon[current][corner], &polygon[current][corner + 1] };
+            if (!BinTriangle(rasterizer, worker, triangle, draw_index)) {
+                SDL_SetAtomicInt(&rasterizer->failed, 1);
+                return;
+            }
+        }
+    }
+}
+
+static float Saturate(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+static Uint32 PackChannel(float value, int channel) {
+    return (Uint32) (Saturate(value) * 255.0f + 0.5f) << (channel * 8);
+}
+
+static __m128 SaturatePS(__m128 value) {
+    return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+static __m128 MixPS(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+static __m128 AbsPS(__m128 value) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+static __m128 SelectPS(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+//  SSE2 has no floor, truncate and step down for negative fractions
+static __m128 FractPS(__m128 value) {
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+    __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+    return _mm_sub_ps(value, floored);
+}
+
+static __m128 SmoothStepPS(__m128 edge0, __m128 edge1, __m128 x) {
+    __m128 t = SaturatePS(_mm_div_ps(_mm_sub_ps(x, edge0), _mm_sub_ps(edge1, edge0)));
+    return _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_add_ps(t, t)));
+}
+
+//  Mirrors grid() in grid.frag for one axis, with the uv derivative passed in
+static __m128 GridAxis(__m128 uv, __m128 uv_derivative) {
+    const __m128 target_width = _mm_set1_ps(0.01f);
+
+    __m128 draw_width = _mm_min_ps(_mm_max_ps(target_width, uv_derivative), _mm_set1_ps(0.5f));
+    __m128 line_aa = _mm_mul_ps(uv_derivative, _mm_set1_ps(1.5f));
+    __m128 fract_uv = FractPS(uv);
+    __m128 grid_uv = _mm_sub_ps(_mm_set1_ps(1.0f), AbsPS(_mm_sub_ps(_mm_add_ps(fract_uv, fract_uv), _mm_set1_ps(1.0f))));
+
+    __m128 mask = SmoothStepPS(_mm_add_ps(draw_width, line_aa), _mm_sub_ps(draw_width, line_aa), grid_uv);
+    mask = _mm_mul_ps(mask, SaturatePS(_mm_div_ps(target_width, draw_width)));
+
+    __m128 fade = SaturatePS(_mm_sub_ps(_mm_add_ps(uv_derivative, uv_derivative), _mm_set1_ps(1.0f)));
+    return MixPS(mask, target_width, fade);
+}
+
+static __m128 Grid(__m128 u, __m128 v, __m128 u_dx, __m128 v_dx, __m128 u_dy, __m128 v_dy, float grid_scale) {
+    __m128 scale = _mm_set1_ps(1.0f / grid_scale);
+    __m128 u_derivative = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(u_dx, u_dx), _mm_mul_ps(u_dy, u_dy))), scale);
+    __m128 v_derivative = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(v_dx, v_dx), _mm_mul_ps(v_dy, v_dy))), scale);
+
+    __m128 mask_u = GridAxis(_mm_mul_ps(u, scale), u_derivative);
+    __m128 mask_v = GridAxis(_mm_mul_ps(v, scale), v_derivative);
+    return MixPS(mask_u, _mm_set1_ps(1.0f), mask_v);
+}
+
+//  Fine derivative across x, lanes are two horizontally adjacent 2x2 quads' rows
+static __m128 DerivativeX(__m128 value) {
+    __m128 right = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 left  = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 0, 0));
+    return _mm_sub_ps(right, left);
+}
+
+static __m128 UnpackChannelPS(__m128i color, int channel) {
+    __m128i value = _mm_and_si128(_mm_srli_epi32(color, channel * 8), _mm_set1_epi32(0xFF));
+    return _mm_mul_ps(_mm_cvtepi32_ps(value), _mm_set1_ps(1.0f / 255.0f));
+}
+
+static __m128i PackColor(__m128 r, __m128 g, __m128 b, __m128 a) {
+    __m128 scale = _mm_set1_ps(255.0f);
+
+    __m128i ri = _mm_cvtps_epi32(_mm_mul_ps(SaturatePS(r), scale));
+    __m128i gi = _mm_cvtps_epi32(_mm_mul_ps(SaturatePS(g), scale));
+    __m128i bi = _mm_cvtps_epi32(_mm_mul_ps(SaturatePS(b), scale));
+    __m128i ai = _mm_cvtps_epi32(_mm_mul_ps(SaturatePS(a), scale));
+
+    __m128i color = _mm_or_si128(ri, _mm_slli_epi32(gi, 8));
+    color = _mm_or_si128(color, _mm_slli_epi32(bi, 16));
+    return _mm_or_si128(color, _mm_slli_epi32(ai, 24));
+}
+
+//  Packs 4 unsigned 32 bit values below 65536 to 16 bits, SSE2 only has a signed saturating pack
+static __m128i PackU16(__m128i values) {
+    __m128i biased = _mm_sub_epi32(values, _mm_set1_epi32(0x8000));
+    return _mm_xor_si128(_mm_packs_epi32(biased, biased), _mm_set1_epi16((short) 0x8000));
+}
+
+static __m128i QuantizeDepth(__m128 depth) {
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(SaturatePS(depth), _mm_set1_ps(65535.0f)), _mm_set1_ps(0.5f)));
+}
+
+static __m128i LoadDepth(const Uint16 *depth_pointer) {
+    return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) depth_pointer), _mm_setzero_si128());
+}
+
+//  Reversed-Z, greater or equal passes
+static __m128i DepthTest(__m128i old_depth, __m128i new_depth) {
+    return _mm_xor_si128(_mm_cmpgt_epi32(old_depth, new_depth), _mm_set1_epi32(-1));
+}
+
+static void WriteColor(Uint32 *color_pointer, __m128i write_mask, __m128i color) {
+    __m128i old_color = _mm_loadu_si128((const __m128i *) color_pointer);
+    color = _mm_or_si128(_mm_and_si128(write_mask, color), _mm_andnot_si128(write_mask, old_color));
+    _mm_storeu_si128((__m128i *) color_pointer, color);
+}
+
+static void WritePixels(Uint32 *color_pointer, Uint16 *depth_pointer, __m128i write_mask, __m128i color, __m128i new_depth, __m128i old_depth) {
+    WriteColor(color_pointer, write_mask, color);
+
+    __m128i depth_to_store = _mm_or_si128(_mm_and_si128(write_mask, new_depth), _mm_andnot_si128(write_mask, old_depth));
+    _mm_storel_epi64((__m128i *) depth_pointer, PackU16(depth_to_store));
+}
+
+//  Blends 4 colors over the destination with src alpha / one minus src alpha, like the GPU pipelines
+static __m128i BlendColor(__m128i destination, __m128 r, __m128 g, __m128 b, __m128 alpha) {
+    __m128 destination_alpha = UnpackChannelPS(destination, 3);
+
+    return PackColor(
+        MixPS(UnpackChannelPS(destination, 0), r, alpha),
+        MixPS(UnpackChannelPS(destination, 1), g, alpha),
+        MixPS(UnpackChannelPS(destination, 2), b, alpha),
+        _mm_add_ps(_mm_mul_ps(alpha, alpha), _mm_mul_ps(destination_alpha, _mm_sub_ps(_mm_set1_ps(1.0f), alpha))));
+}
+
+//  Mirrors grid.frag, drawn after the opaque triangles: depth tested without writing, and blended.
+//  Shades 4x2 pixels at a time, two 2x2 quads side by side, so uv derivatives match the GPU's fine
+//  derivatives.
+static void ShadeGridTile(SoftRasterizer *rasterizer, int tile_x0, int tile_y0, int tile_x1, int tile_y1) {
+    const HMM_Mat4 *view_projection = &rasterizer->frame->view_projection_matrix;
+
+    __m128 ndc_scale_x = _mm_set1_ps(2.0f / rasterizer->width);
+    __m128 ndc_scale_y = _mm_set1_ps(-2.0f / rasterizer->height);
+    __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 one = _mm_set1_ps(1.0f);
+
+    for (int y = tile_y0; y < tile_y1; y += 2) {
+        for (int x = tile_x0; x < tile_x1; x += 4) {
+            __m128 ndc_x = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps((float) x), lane_offsets), ndc_scale_x), one);
+
+            __m128 world[2][3];
+            __m128 t[2];
+            for (int row = 0; row < 2; ++row) {
+                __m128 ndc_y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(y + row + 0.5f), ndc_scale_y), one);
+
+                __m128 near[3], far[3];
+                for (int axis = 0; axis < 3; ++axis) {
+                    near[axis] = _mm_add_ps(_mm_set1_ps(rasterizer->grid_near_center.Elements[axis]),
+                        _mm_add_ps(_mm_mul_ps(ndc_x, _mm_set1_ps(rasterizer->grid_near_x.Elements[axis])), _mm_mul_ps(ndc_y, _mm_set1_ps(rasterizer->grid_near_y.Elements[axis]))));
+                    far[axis] = _mm_add_ps(_mm_set1_ps(rasterizer->grid_far_center.Elements[axis]),
+                        _mm_add_ps(_mm_mul_ps(ndc_x, _mm_set1_ps(rasterizer->grid_far_x.Elements[axis])), _mm_mul_ps(ndc_y, _mm_set1_ps(rasterizer->grid_far_y.Elements[axis]))));
+                }
+
+                t[row] = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), near[1]), _mm_sub_ps(far[1], near[1]));
+                for (int axis = 0; axis < 3; ++axis) {
+                    world[row][axis] = _mm_add_ps(near[axis], _mm_mul_ps(_mm_sub_ps(far[axis], near[axis]), t[row]));
+                }
+            }
+
+            //  Rays that meet the plane behind the camera are above the horizon
+            __m128 above_horizon = _mm_and_ps(_mm_cmplt_ps(t[0], _mm_setzero_ps()), _mm_cmplt_ps(t[1], _mm_setzero_ps()));
+            if (_mm_movemask_ps(above_horizon) == 0xF) {
+                continue;
+            }
+
+            __m128i write_mask[2];
+            for (int row = 0; row < 2; ++row) {
+                __m128 clip_z = _mm_set1_ps(view_projection->Elements[3][2]);
+                __m128 clip_w = _mm_set1_ps(view_projection->Elements[3][3]);
+                for (int axis = 0; axis < 3; ++axis) {
+                    clip_z = _mm_add_ps(clip_z, _mm_mul_ps(world[row][axis], _mm_set1_ps(view_projection->Elements[axis][2])));
+                    clip_w = _mm_add_ps(clip_w, _mm_mul_ps(world[row][axis], _mm_set1_ps(view_projection->Elements[axis][3])));
+                }
+
+                __m128 depth = _mm_div_ps(clip_z, clip_w);
+
+                //  Past the far plane the grid geometry is clipped
+                __m128 on_grid = _mm_and_ps(_mm_cmpge_ps(t[row], _mm_setzero_ps()), _mm_cmpge_ps(depth, _mm_setzero_ps()));
+
+                __m128i old_depth = LoadDepth(&rasterizer->depth[(size_t) (y + row) * rasterizer->pitch + x]);
+                write_mask[row] = _mm_and_si128(_mm_castps_si128(on_grid), DepthTest(old_depth, QuantizeDepth(depth)));
+            }
+
+            //  Like early-Z, skip shading where the grid is hidden or missing in the whole block
+            if (_mm_movemask_epi8(_mm_or_si128(write_mask[0], write_mask[1])) == 0) {
+                continue;
+            }
+
+            __m128 u_dy = _mm_sub_ps(world[1][0], world[0][0]);
+            __m128 v_dy = _mm_sub_ps(world[1][2], world[0][2]);
+
+            for (int row = 0; row < 2; ++row) {
+                __m128 u = world[row][0];
+                __m128 v = world[row][2];
+                __m128 u_dx = DerivativeX(u);
+                __m128 v_dx = DerivativeX(v);
+
+                __m128 grid_mask = Grid(u, v, u_dx, v_dx, u_dy, v_dy, 0.1f);
+                grid_mask = MixPS(grid_mask, one, Grid(u, v, u_dx, v_dx, u_dy, v_dy, 1.0f));
+                grid_mask = MixPS(grid_mask, one, Grid(u, v, u_dx, v_dx, u_dy, v_dy, 10.0f));
+
+                __m128 x_axis = _mm_cmplt_ps(AbsPS(u), _mm_set1_ps(0.1f));
+                __m128 z_axis = _mm_cmplt_ps(AbsPS(v), _mm_set1_ps(0.1f));
+                __m128 r = SelectPS(z_axis, SelectPS(x_axis, _mm_set1_ps(0.5f), _mm_set1_ps(0.3f)), _mm_set1_ps(0.8f));
+                __m128 g = SelectPS(z_axis, SelectPS(x_axis, _mm_set1_ps(0.5f), _mm_set1_ps(0.3f)), _mm_set1_ps(0.3f));
+                __m128 b = SelectPS(z_axis, SelectPS(x_axis, _mm_set1_ps(0.5f), _mm_set1_ps(0.8f)), _mm_set1_ps(0.3f));
+
+                Uint32 *color_pointer = &rasterizer->color[(size_t) (y + row) * rasterizer->pitch + x];
+                __m128i destination = _mm_loadu_si128((const __m128i *) color_pointer);
+                WriteColor(color_pointer, write_mask[row], BlendColor(destination, r, g, b, grid_mask));
+            }
+        }
+    }
+}
+
+//  Mirrors color.frag, or transparent.frag when given the tile's OIT targets, in which case depth is
+//  tested but not written, and the fragment is accumulated instead of written
+static void RasterTriangle(SoftRasterizer *rasterizer, const SoftTriangle *triangle, float *oit_targets, int tile_x0, int tile_y0, int tile_x1, int tile_y1) {
+    int min_x = SDL_max(triangle->min_x, tile_x0) & ~3;
+    int min_y = SDL_max(triangle->min_y, tile_y0);
+    int max_x = SDL_min(triangle->max_x, tile_x1 - 1);
+    int max_y = SDL_min(triangle->max_y, tile_y1 - 1);
+
+    __m128 edge_a[3], edge_b[3], edge_c[3], top_left[3];
+    for (int i = 0; i < 3; ++i) {
+        edge_a[i] = _mm_set1_ps(triangle->edge_a[i]);
+        edge_b[i] = _mm_set1_ps(triangle->edge_b[i]);
+        edge_c[i] = _mm_set1_ps(triangle->edge_c[i]);
+        top_left[i] = _mm_castsi128_ps(_mm_set1_epi32((triangle->top_left_mask & (1u << i)) ? -1 : 0));
+    }
+
+    __m128 inv_area = _mm_set1_ps(triangle->inv_area);
+    __m128 zero = _mm_setzero_ps();
+    __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+    const HMM_Vec3 light_direction = rasterizer->frame->light_direction;
+    __m128 tint_r = _mm_set1_ps(0.7f);
+    __m128 tint_g = _mm_set1_ps(0.4f);
+    __m128 tint_b = _mm_set1_ps(0.3f);
+    __m128 alpha = _mm_set1_ps(1.0f);
+
+    if (oit_targets) {
+        HMM_Vec4 color = GetDraw(rasterizer->frame, triangle->draw_index)->color;
+        tint_r = _mm_set1_ps(color.R);
+        tint_g = _mm_set1_ps(color.G);
+        tint_b = _mm_set1_ps(color.B);
+        alpha = _mm_set1_ps(color.A);
+    }
+
+    for (int y = min_y; y <= max_y; ++y) {
+        __m128 pixel_y = _mm_set1_ps(y + 0.5f);
+
+        for (int x = min_x; x <= max_x; x += 4) {
+            __m128 pixel_x = _mm_add_ps(_mm_set1_ps((float) x), lane_offsets);
+
+            __m128 edges[3];
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int i = 0; i < 3; ++i) {
+                edges[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge_a[i], pixel_x), _mm_mul_ps(edge_b[i], pixel_y)), edge_c[i]);
+                __m128 on_edge = _mm_and_ps(_mm_cmpeq_ps(edges[i], zero), top_left[i]);
+                inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edges[i], zero), on_edge));
+            }
+
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            __m128 weights[3];
+            for (int i = 0; i < 3; ++i) {
+                weights[i] = _mm_mul_ps(edges[i], inv_area);
+            }
+
+            __m128 depth = _mm_mul_ps(weights[0], _mm_set1_ps(triangle->depth[0]));
+            depth = _mm_add_ps(depth, _mm_mul_ps(weights[1], _mm_set1_ps(triangle->depth[1])));
+            depth = _mm_add_ps(depth, _mm_mul_ps(weights[2], _mm_set1_ps(triangle->depth[2])));
+            __m128i new_depth = QuantizeDepth(depth);
+
+            size_t pixel = (size_t) y * rasterizer->pitch + x;
+            Uint16 *depth_pointer = &rasterizer->depth[pixel];
+            Uint32 *color_pointer = &rasterizer->color[pixel];
+
+            //  Depth is tested before shading, like the GPU's early-Z
+            __m128i old_depth = LoadDepth(depth_pointer);
+            __m128i write_mask = _mm_and_si128(_mm_castps_si128(inside), DepthTest(old_depth, new_depth));
+
+            if (_mm_movemask_epi8(write_mask) == 0) {
+                continue;
+            }
+
+            __m128 inv_w = _mm_mul_ps(weights[0], _mm_set1_ps(triangle->inv_w[0]));
+            inv_w = _mm_add_ps(inv_w, _mm_mul_ps(weights[1], _mm_set1_ps(triangle->inv_w[1])));
+            inv_w = _mm_add_ps(inv_w, _mm_mul_ps(weights[2], _mm_set1_ps(triangle->inv_w[2])));
+            __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), inv_w);
+
+            __m128 light_intensity = _mm_set1_ps(0.5f);
+            for (int component = 0; component < 3; ++component) {
+                __m128 normal = _mm_mul_ps(weights[0], _mm_set1_ps(triangle->normal_over_w[0][component]));
+                normal = _mm_add_ps(normal, _mm_mul_ps(weights[1], _mm_set1_ps(triangle->normal_over_w[1][component])));
+                normal = _mm_add_ps(normal, _mm_mul_ps(weights[2], _mm_set1_ps(triangle->normal_over_w[2][component])));
+                normal = _mm_mul_ps(normal, w);
+
+                light_intensity = _mm_sub_ps(light_intensity, _mm_mul_ps(normal, _mm_set1_ps(light_direction.Elements[component])));
+            }
+
+            __m128 r = _mm_mul_ps(light_intensity, tint_r);
+            __m128 g = _mm_mul_ps(light_intensity, tint_g);
+            __m128 b = _mm_mul_ps(light_intensity, tint_b);
+
+            if (!oit_targets) {
+                WritePixels(color_pointer, depth_pointer, write_mask, PackColor(r, g, b, alpha), new_depth, old_depth);
+                continue;
+            }
+
+            //  Equation 9 from McGuire and Bavoil, w being the view depth. Lanes that failed coverage
+            //  or the depth test get zero weight and alpha, which leaves both targets untouched.
+            __m128 depth_over_200 = _mm_mul_ps(w, _mm_set1_ps(1.0f / 200.0f));
+            __m128 depth_over_200_squared = _mm_mul_ps(depth_over_200, depth_over_200);
+            __m128 weight = _mm_div_ps(_mm_set1_ps(0.03f), _mm_add_ps(_mm_set1_ps(1e-5f), _mm_mul_ps(depth_over_200_squared, depth_over_200_squared)));
+            weight = _mm_min_ps(_mm_max_ps(weight, _mm_set1_ps(1e-2f)), _mm_set1_ps(3e3f));
+
+            __m128 masked_alpha = _mm_and_ps(alpha, _mm_castsi128_ps(write_mask));
+            weight = _mm_mul_ps(weight, masked_alpha);
+
+            float *accumulation = &oit_targets[(y - tile_y0) * SOFT_TILE_SIZE + (x - tile_x0)];
+            float *revealage = &accumulation[SOFT_TILE_PIXELS * 4];
+
+            __m128 accumulated[4] = { _mm_mul_ps(r, alpha), _mm_mul_ps(g, alpha), _mm_mul_ps(b, alpha), alpha };
+            for (int channel = 0; channel < 4; ++channel) {
+                float *target = &accumulation[SOFT_TILE_PIXELS * channel];
+                _mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), _mm_mul_ps(accumulated[channel], weight)));
+            }
+
+            _mm_storeu_ps(revealage, _mm_mul_ps(_mm_loadu_ps(revealage), _mm_sub_ps(_mm_set1_ps(1.0f), masked_alpha)));
+        }
+    }
+}
+
+static void ClearTransparentTile(float *oit_targets) {
+    for (int i = 0; i < SOFT_TILE_PIXELS * 4; ++i) {
+        oit_targets[i] = 0.0f;
+    }
+
+    for (int i = SOFT_TILE_PIXELS * 4; i < SOFT_TILE_PIXELS * 5; ++i) {
+        oit_targets[i] = 1.0f;
+    }
+}
+
+//  Mirrors oit_composite.frag, resolving the tile's OIT targets over its color
+static void CompositeTransparentTile(SoftRasterizer *rasterizer, const float *oit_targets, int tile_x0, int tile_y0) {
+    __m128 one = _mm_set1_ps(1.0f);
+
+    for (int y = 0; y < SOFT_TILE_SIZE; ++y) {
+        for (int x = 0; x < SOFT_TILE_SIZE; x += 4) {
+            const float *accumulation = &oit_targets[y * SOFT_TILE_SIZE + x];
+
+            __m128 revealage = _mm_loadu_ps(&accumulation[SOFT_TILE_PIXELS * 4]);
+            __m128 covered = _mm_cmplt_ps(revealage, one);
+            if (_mm_movemask_ps(covered) == 0) {
+                continue;
+            }
+
+            __m128 total_alpha = _mm_loadu_ps(&accumulation[SOFT_TILE_PIXELS * 3]);
+            __m128 inv_total_alpha = _mm_div_ps(one, _mm_min_ps(_mm_max_ps(total_alpha, _mm_set1_ps(1e-4f)), _mm_set1_ps(5e4f)));
+
+            __m128 r = _mm_mul_ps(_mm_loadu_ps(&accumulation[0]), inv_total_alpha);
+            __m128 g = _mm_mul_ps(_mm_loadu_ps(&accumulation[SOFT_TILE_PIXELS]), inv_total_alpha);
+            __m128 b = _mm_mul_ps(_mm_loadu_ps(&accumulation[SOFT_TILE_PIXELS * 2]), inv_total_alpha);
+
+            Uint32 *color_pointer = &rasterizer->color[(size_t) (tile_y0 + y) * rasterizer->pitch + tile_x0 + x];
+            __m128i destination = _mm_loadu_si128((const __m128i *) color_pointer);
+            WriteColor(color_pointer, _mm_castps_si128(covered), BlendColor(destination, r, g, b, _mm_sub_ps(one, revealage)));
+        }
+    }
+}
+
+static void RasterTilesJob(SoftRasterizer *rasterizer, SoftWorker *worker) {
+    const SoftFrame *frame = rasterizer->frame;
+    Uint32 num_tiles = rasterizer->num_tiles_x * rasterizer->num_tiles_y;
+
+    Uint32 clear_color =
+        PackChannel(frame->clear_color.X, 0) |
+        PackChannel(frame->clear_color.Y, 1) |
+        PackChannel(frame->clear_color.Z, 2) |
+        PackChannel(frame->clear_color.W, 3);
+
+    for (;;) {
+        Uint32 tile = (Uint32) SDL_AddAtomicInt(&rasterizer->next_tile, 1);
+        if (tile >= num_tiles) {
+            break;
+        }
+
+        int tile_x0 = (tile % rasterizer->num_tiles_x) * SOFT_TILE_SIZE;
+        int tile_y0 = (tile / rasterizer->num_tiles_x) * SOFT_TILE_SIZE;
+        int tile_x1 = tile_x0 + SOFT_TILE_SIZE;
+        int tile_y1 = tile_y0 + SOFT_TILE_SIZE;
+
+        for (int y = tile_y0; y < tile_y1; ++y) {
+            Uint32 *color = &rasterizer->color[(size_t) y * rasterizer->pitch + tile_x0];
+            Uint16 *depth = &rasterizer->depth[(size_t) y * rasterizer->pitch + tile_x0];
+            for (int x = 0; x < SOFT_TILE_SIZE; ++x) {
+                color[x] = clear_color;
+                depth[x] = 0;
+            }
+        }
+
+        //  Walking the workers in order keeps triangles in submission order. Opaque triangles go
+        //  first, so the grid is only shaded where they leave it visible.
+        bool has_transparent_triangles = false;
+        for (int i = 0; i < rasterizer->num_threads; ++i) {
+            const SoftWorker *binning_worker = &rasterizer->workers[i];
+            const SoftBin *bin = &binning_worker->bins[tile];
+
+            for (Uint32 j = 0; j < bin->num_triangles; ++j) {
+                const SoftTriangle *triangle = &binning_worker->triangles[bin->triangles[j]];
+                if (triangle->draw_index >= frame->num_draws) {
+                    has_transparent_triangles = true;
+                    continue;
+                }
+
+                RasterTriangle(rasterizer, triangle, NULL, tile_x0, tile_y0, tile_x1, tile_y1);
+            }
+        }
+
+        ShadeGridTile(rasterizer, tile_x0, tile_y0, tile_x1, tile_y1);
+
+        if (!has_transparent_triangles) {
+            continue;
+        }
+
+        ClearTransparentTile(worker->oit_targets);
+
+        for (int i = 0; i < rasterizer->num_threads; ++i) {
+            const SoftWorker *binning_worker = &rasterizer->workers[i];
+            const SoftBin *bin = &binning_worker->bins[tile];
+
+            for (Uint32 j = 0; j < bin->num_triangles; ++j) {
+                const SoftTriangle *triangle = &binning_worker->triangles[bin->triangles[j]];
+                if (triangle->draw_index >= frame->num_draws) {
+                    RasterTriangle(rasterizer, triangle, worker->oit_targets, tile_x0, tile_y0, tile_x1, tile_y1);
+                }
+            }
+        }
+
+        CompositeTransparentTile(rasterizer, worker->oit_targets, tile_x0, tile_y0);
+    }
+}
+
+static void FreeTargets(SoftRasterizer *rasterizer) {
+    for (int i = 0; i < rasterizer->num_threads; ++i) {
+        SoftWorker *worker = &rasterizer->workers[i];
+        if (worker->bins) {
+            for (Uint32 tile = 0; tile < rasterizer->num_tiles_x * rasterizer->num_tiles_y; ++tile) {
+                SDL_free(worker->bins[tile].triangles);
+            }
+            SDL_free(worker->bins);
+            worker->bins = NULL;
+        }
+
+        SDL_free(worker->oit_targets);
+        worker->oit_targets = NULL;
+    }
+
+    SDL_free(rasterizer->color);
+    SDL_free(rasterizer->depth);
+    rasterizer->color = NULL;
+    rasterizer->depth = NULL;
+
+    rasterizer->width = rasterizer->height = 0;
+    rasterizer->num_tiles_x = rasterizer->num_tiles_y = 0;
+    rasterizer->pitch = 0;
+}
+
+SoftRasterizer *CreateSoftRasterizer(int num_threads) {
+    SoftRasterizer *rasterizer = SDL_calloc(1, sizeof(SoftRasterizer));
+    if (!rasterizer) {
+        return NULL;
+    }
+
+    if (num_threads <= 0) {
+        num_threads = SDL_GetNumLogicalCPUCores();
+    }
+
+    num_threads = SDL_clamp(num_threads, 1, SOFT_MAX_THREADS);
+
+    rasterizer->job_finished = SDL_CreateSemaphore(0);
+    if (!rasterizer->job_finished) {
+        SDL_free(rasterizer);
+        return NULL;
+    }
+
+    rasterizer->num_threads = 1;
+    rasterizer->workers[0].rasterizer = rasterizer;
+
+    for (int i = 1; i < num_threads; ++i) {
+        SoftWorker *worker = &rasterizer->workers[i];
+        worker->rasterizer = rasterizer;
+        worker->index = i;
+
+        worker->start = SDL_CreateSemaphore(0);
+        if (!worker->start) {
+            break;
+        }
+
+        worker->thread = SDL_CreateThread(SoftWorkerThread, "Soft Rasterizer", worker);
+        if (!worker->thread) {
+            SDL_DestroySemaphore(worker->start);
+            worker->start = NULL;
+            break;
+        }
+
+        rasterizer->num_threads += 1;
+    }
+
+    return rasterizer;
+}
+
+void DestroySoftRasterizer(SoftRasterizer *rasterizer) {
+    if (!rasterizer) {
+        return;
+    }
+
+    FreeTargets(rasterizer);
+
+    SDL_SetAtomicInt(&rasterizer->quit, 1);
+    for (int i = 1; i < rasterizer->num_threads; ++i) {
+        SDL_SignalSemaphore(rasterizer->workers[i].start);
+    }
+
+    for (int i = 0; i < rasterizer->num_threads; ++i) {
+        SoftWorker *worker = &rasterizer->workers[i];
+        if (worker->thread) {
+            SDL_WaitThread(worker->thread, NULL);
+            SDL_DestroySemaphore(worker->start);
+        }
+
+        SDL_free(worker->triangles);
+    }
+
+    SDL_DestroySemaphore(rasterizer->job_finished);
+
+    SDL_free(rasterizer->vertices);
+    SDL_free(rasterizer->draw_mvp_matrices);
+    SDL_free(rasterizer->draw_first_vertex);
+    SDL_free(rasterizer->draw_first_triangle);
+    SDL_free(rasterizer);
+}
+
+bool ResizeSoftRasterizer(SoftRasterizer *rasterizer, Uint32 width, Uint32 height) {
+    if (rasterizer->width == width && rasterizer->height == height && rasterizer->color) {
+        return true;
+    }
+
+    FreeTargets(rasterizer);
+
+    if (width == 0 || height == 0) {
+        return SDL_SetError("Software rasterizer target must not be empty.");
+    }
+
+    Uint32 num_tiles_x = (width + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    Uint32 num_tiles_y = (height + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    Uint32 pitch = num_tiles_x * SOFT_TILE_SIZE;
+    size_t num_pixels = (size_t) pitch * num_tiles_y * SOFT_TILE_SIZE;
+
+    rasterizer->color = SDL_malloc(num_pixels * sizeof(Uint32));
+    rasterizer->depth = SDL_malloc(num_pixels * sizeof(Uint16));
+
+    bool allocated = rasterizer->color && rasterizer->depth;
+    for (int i = 0; allocated && i < rasterizer->num_threads; ++i) {
+        rasterizer->workers[i].bins = SDL_calloc(num_tiles_x * num_tiles_y, sizeof(SoftBin));
+        rasterizer->workers[i].oit_targets = SDL_malloc(SOFT_TILE_PIXELS * 5 * sizeof(float));
+        allocated = rasterizer->workers[i].bins && rasterizer->workers[i].oit_targets;
+    }
+
+    rasterizer->width = width;
+    rasterizer->height = height;
+    rasterizer->num_tiles_x = num_tiles_x;
+    rasterizer->num_tiles_y = num_tiles_y;
+    rasterizer->pitch = pitch;
+
+    if (!allocated) {
+        FreeTargets(rasterizer);
+        return SDL_SetError("Out of memory creating %ux%u software render target.", width, height);
+    }
+
+    return true;
+}
+
+static HMM_Vec3 Deproject(const HMM_Mat4 *inv_view_projection, float x, float y, float z) {
+    HMM_Vec4 point = HMM_MulM4V4(*inv_view_projection, HMM_V4(x, y, z, 1.0f));
+    return HMM_DivV3F(point.XYZ, point.W);
+}
+
+bool RenderSoftFrame(SoftRasterizer *rasterizer, const SoftFrame *frame) {
+    if (!rasterizer->color) {
+        return SDL_SetError("Software rasterizer has no render target.");
+    }
+
+    rasterizer->frame = frame;
+    SDL_SetAtomicInt(&rasterizer->failed, 0);
+
+    Uint32 num_draws = frame->num_draws + frame->num_transparent_draws;
+    rasterizer->num_draws = num_draws;
+
+    bool reserved =
+        Reserve((void **) &rasterizer->draw_mvp_matrices, &rasterizer->draw_mvp_matrices_capacity, num_draws, sizeof(HMM_Mat4)) &&
+        Reserve((void **) &rasterizer->draw_first_vertex, &rasterizer->draw_first_vertex_capacity, num_draws + 1, sizeof(Uint32)) &&
+        Reserve((void **) &rasterizer->draw_first_triangle, &rasterizer->draw_first_triangle_capacity, num_draws + 1, sizeof(Uint32));
+    if (!reserved) {
+        return SDL_SetError("Out of memory preparing %u software draws.", num_draws);
+    }
+
+    rasterizer->num_vertices = 0;
+    rasterizer->num_triangles = 0;
+    for (Uint32 i = 0; i < num_draws; ++i) {
+        const SoftMeshDraw *draw = GetDraw(frame, i);
+        rasterizer->draw_mvp_matrices[i] = HMM_MulM4(frame->view_projection_matrix, draw->model_matrix);
+        rasterizer->draw_first_vertex[i] = rasterizer->num_vertices;
+        rasterizer->draw_first_triangle[i] = rasterizer->num_triangles;
+        rasterizer->num_vertices += draw->num_vertices;
+        rasterizer->num_triangles += draw->num_indices / 3;
+    }
+    rasterizer->draw_first_vertex[num_draws] = rasterizer->num_vertices;
+    rasterizer->draw_first_triangle[num_draws] = rasterizer->num_triangles;
+
+    if (!Reserve((void **) &rasterizer->vertices, &rasterizer->vertices_capacity, rasterizer->num_vertices, sizeof(SoftVertex))) {
+        return SDL_SetError("Out of memory transforming %u software vertices.", rasterizer->num_vertices);
+    }
+
+    //  Depth is reversed, the near plane is at z = 1 and the far plane at z = 0
+    const HMM_Mat4 *inv_view_projection = &frame->inv_view_projection_matrix;
+    HMM_Vec3 near_bottom_left  = Deproject(inv_view_projection, -1, -1, 1);
+    HMM_Vec3 near_bottom_right = Deproject(inv_view_projection,  1, -1, 1);
+    HMM_Vec3 near_top_left     = Deproject(inv_view_projection, -1,  1, 1);
+    HMM_Vec3 far_bottom_left   = Deproject(inv_view_projection, -1, -1, 0);
+    HMM_Vec3 far_bottom_right  = Deproject(inv_view_projection,  1, -1, 0);
+    HMM_Vec3 far_top_left      = Deproject(inv_view_projection, -1,  1, 0);
+
+    rasterizer->grid_near_x = HMM_MulV3F(HMM_SubV3(near_bottom_right, near_bottom_left), 0.5f);
+    rasterizer->grid_near_y = HMM_MulV3F(HMM_SubV3(near_top_left, near_bottom_left), 0.5f);
+    rasterizer->grid_near_center = HMM_AddV3(near_bottom_left, HMM_AddV3(rasterizer->grid_near_x, rasterizer->grid_near_y));
+    rasterizer->grid_far_x = HMM_MulV3F(HMM_SubV3(far_bottom_right, far_bottom_left), 0.5f);
+    rasterizer->grid_far_y = HMM_MulV3F(HMM_SubV3(far_top_left, far_bottom_left), 0.5f);
+    rasterizer->grid_far_center = HMM_AddV3(far_bottom_left, HMM_AddV3(rasterizer->grid_far_x, rasterizer->grid_far_y));
+
+    RunJob(rasterizer, TransformVerticesJob);
+    RunJob(rasterizer, BinTrianglesJob);
+
+    if (SDL_GetAtomicInt(&rasterizer->failed)) {
+        return SDL_SetError("Out of memory binning %u software triangles.", rasterizer->num_triangles);
+    }
+
+    SDL_SetAtomicInt(&rasterizer->next_tile, 0);
+    RunJob(rasterizer, RasterTilesJob);
+
+    rasterizer->frame = NULL;
+    return true;
+}
+
+bool ValidateSoftMeshIndices(const Uint32 *indices, Uint32 num_indices, Uint32 num_vertices) {
+    for (Uint32 i = 0; i < num_indices; ++i) {
+        if (indices[i] >= num_vertices) {
+            return SDL_SetError("Software mesh has index %u at %u, but only %u vertices.", indices[i], i, num_vertices);
+        }
+    }
+
+    return true;
+}
+
+const Uint32 *GetSoftColorBuffer(const SoftRasterizer *rasterizer, Uint32 *width, Uint32 *height, Uint32 *pitch) {
+    *width = rasterizer->width;
+    *height = rasterizer->height;
+    *pitch = rasterizer->pitch;
+    return rasterizer->color;
+}
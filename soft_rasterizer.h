@@ -0,0 +1,61 @@
+#ifndef SOFT_RASTERIZER_H
+#define SOFT_RASTERIZER_H
+
+#include "SDL3/SDL.h"
+
+#include "HandmadeMath.h"
+
+#include "obj_loader.h"
+
+//  CPU implementation of the mesh, grid and transparency passes, for machines without a GPU and for
+//  headless image regression tests. Follows the GPU pipelines as closely as it can: reversed-Z D16
+//  depth with a greater-or-equal test, back face culling of counter clockwise front faces, opaque
+//  meshes first, then the grid blended over them without writing depth, then transparent meshes
+//  resolved with weighted blended order independent transparency, into an RGBA8 target.
+//
+//  Triangles are set up and binned into 64x64 tiles on every core, then tiles are rasterized in
+//  parallel with SSE edge functions, 4 pixels at a time.
+
+typedef struct SoftRasterizer SoftRasterizer;
+
+//  Indices are not bounds checked per frame, every one must be below num_vertices.
+//  Check each mesh once with ValidateSoftMeshIndices when it's loaded.
+typedef struct SoftMeshDraw {
+    const ObjVertex *vertices;
+    Uint32 num_vertices;
+
+    const Uint32 *indices;
+    Uint32 num_indices;
+
+    HMM_Mat4 model_matrix;
+    HMM_Mat4 model_rotation_matrix;
+
+    //  Only used by transparent draws
+    HMM_Vec4 color;
+} SoftMeshDraw;
+
+typedef struct SoftFrame {
+    HMM_Mat4 view_projection_matrix;
+    HMM_Mat4 inv_view_projection_matrix;
+    HMM_Vec3 light_direction;
+    HMM_Vec4 clear_color;
+
+    const SoftMeshDraw *draws;
+    Uint32 num_draws;
+
+    const SoftMeshDraw *transparent_draws;
+    Uint32 num_transparent_draws;
+} SoftFrame;
+
+//  num_threads <= 0 uses every logical core
+SoftRasterizer *CreateSoftRasterizer(int num_threads);
+void DestroySoftRasterizer(SoftRasterizer *rasterizer);
+
+bool ResizeSoftRasterizer(SoftRasterizer *rasterizer, Uint32 width, Uint32 height);
+bool RenderSoftFrame(SoftRasterizer *rasterizer, const SoftFrame *frame);
+bool ValidateSoftMeshIndices(const Uint32 *indices, Uint32 num_indices, Uint32 num_vertices);
+
+//  RGBA8 (SDL_PIXELFORMAT_RGBA32), pitch is in pixels
+const Uint32 *GetSoftColorBuffer(const SoftRasterizer *rasterizer, Uint32 *width, Uint32 *height, Uint32 *pitch);
+
+#endif
@@ -0,0 +1,33 @@
+#version 460
+#extension GL_ARB_shading_language_include : require
+
+// Weighted blended order independent transparency, McGuire and Bavoil 2013.
+// Accumulation is blended ONE, ONE and revealage ZERO, ONE_MINUS_SRC_COLOR, then resolved by oit_composite.frag.
+
+layout (location = 0) out vec4 accumulation;
+layout (location = 1) out float revealage;
+
+layout (location = 3) in VertexOutput {
+    vec2 uv;
+    vec3 world_normal;
+    flat float instance_index;
+    vec4 color;
+    vec3 world_position;
+} vertex_output;
+
+#define COMMON_UNIFORM_BINDING_SET 3
+#include "common_uniforms.glsl"
+#include "fragment_uniforms.glsl"
+#include "per_instance_fragment_uniforms.glsl"
+
+void main() {
+    float light_intensity = dot(vertex_output.world_normal, -fragment_uniforms.light_direction) + 1 * 0.5;
+    vec4 color = vec4(light_intensity.rrr * per_instance_fragment_uniforms.color.rgb, per_instance_fragment_uniforms.color.a);
+
+    // Equation 9 from the paper, nearer surfaces get more weight
+    float view_depth = 1.0 / gl_FragCoord.w;
+    float weight = color.a * clamp(0.03 / (1e-5 + pow(view_depth / 200.0, 4.0)), 1e-2, 3e3);
+
+    accumulation = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a;
+}